@@ -0,0 +1,305 @@
+#include "imagekernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QPainter>
+#include <QSize>
+
+/**
+ * @brief 一项测量：同一个核的标量实现与当前CPU上最快的实现，以及作为参照的QImage操作
+ *
+ * 核在单个线程中处理整幅图片，与QImage的操作（同样是单线程）直接可比
+ */
+struct Benchmark
+{
+    char const *name;
+
+    //! 参照的QImage操作，没有对应的操作时为空
+    char const *baseline;
+    std::function<void()> qimage;
+
+    //! kernel写出的字节数，标量与最快实现的结果按字节比较
+    std::size_t outputBytes;
+    std::function<void(ImageKernels const &, std::uint8_t *out)> kernel;
+};
+
+//! 预乘alpha的随机图片：多数像素不透明，颜色不大于alpha
+static QImage randomImage(QSize const &size, unsigned int seed)
+{
+    std::mt19937 random(seed);
+    std::uniform_int_distribution<int> byte(0, 255);
+
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+
+    for (int y = 0; y < size.height(); ++y) {
+        auto row = reinterpret_cast<std::uint32_t *>(image.scanLine(y));
+
+        for (int x = 0; x < size.width(); ++x) {
+            int const alpha = byte(random) < 192 ? 255 : byte(random);
+
+            std::uint32_t pixel = static_cast<std::uint32_t>(alpha) << 24;
+            for (int c = 0; c < 3; ++c)
+                pixel |= static_cast<std::uint32_t>(byte(random) * alpha / 255) << (8 * c);
+
+            row[x] = pixel;
+        }
+    }
+
+    return image;
+}
+
+static ConstImageView constView(QImage const &image)
+{
+    return { image.constBits(), image.width(), image.height(), image.bytesPerLine() };
+}
+
+//! 以out为缓冲区、每行紧密排列的图片
+static ImageView outputView(std::uint8_t *out, QSize const &size)
+{
+    return { out, size.width(), size.height(), static_cast<std::ptrdiff_t>(size.width()) * 4 };
+}
+
+//! repeat次中最快的一次（毫秒）
+static double bestOf(int repeat, std::function<void()> const &function)
+{
+    double best = std::numeric_limits<double>::max();
+
+    for (int i = 0; i < repeat; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+
+        function();
+
+        best = std::min(best, timer.nsecsElapsed() / 1e6);
+    }
+
+    return best;
+}
+
+static std::vector<Benchmark> benchmarks(QImage const &a, QImage const &b)
+{
+    QSize const size = a.size();
+    QSize const scaledSize = (size * 3 / 5).expandedTo(QSize(1, 1));
+
+    std::size_t const imageBytes = static_cast<std::size_t>(size.width()) * size.height() * 4;
+
+    static float const sharpen[9] = { 0.0f, -1.0f, 0.0f, -1.0f, 5.0f, -1.0f, 0.0f, -1.0f, 0.0f };
+    static float const saturating[9] = { 100.0f, 20.0f, -100.0f, 20.0f, 100.0f, 20.0f, -50.0f, 20.0f, 0.5f };
+
+    constexpr int BlendWeight = 100;
+    constexpr int ThresholdLevel = 128;
+    constexpr int BlurRadius = 8;
+
+    std::vector<Benchmark> result;
+
+    result.push_back({ "blend", "QPainter::drawImage with opacity", [a, b] {
+        QImage target = a.copy();
+        QPainter painter(&target);
+        painter.setOpacity(BlendWeight / 256.0);
+        painter.drawImage(0, 0, b);
+    }, imageBytes, [a, b, size](ImageKernels const &kernels, std::uint8_t *out) {
+        kernels.blend(constView(a), constView(b), outputView(out, size), BlendWeight, 0, size.height());
+    } });
+
+    result.push_back({ "grayscale", "convertToFormat(Format_Grayscale8)", [a] {
+        a.convertToFormat(QImage::Format_Grayscale8);
+    }, imageBytes, [a, size](ImageKernels const &kernels, std::uint8_t *out) {
+        kernels.grayscale(constView(a), outputView(out, size), 0, size.height());
+    } });
+
+    result.push_back({ "threshold", "convertToFormat(Format_Mono, ThresholdDither)", [a] {
+        a.convertToFormat(QImage::Format_Mono, Qt::ThresholdDither);
+    }, imageBytes, [a, size](ImageKernels const &kernels, std::uint8_t *out) {
+        kernels.threshold(constView(a), outputView(out, size), ThresholdLevel, 0, size.height());
+    } });
+
+    // both passes, as the blur model runs them
+    result.push_back({ "box blur", nullptr, nullptr, imageBytes, [a, size](ImageKernels const &kernels, std::uint8_t *out) {
+        QImage pass(size, QImage::Format_ARGB32_Premultiplied);
+        ImageView const passView { pass.bits(), pass.width(), pass.height(), pass.bytesPerLine() };
+
+        kernels.boxBlurHorizontal(constView(a), passView, BlurRadius, 0, size.height());
+        kernels.boxBlurVertical(passView, outputView(out, size), BlurRadius, 0, size.height());
+    } });
+
+    result.push_back({ "resize bilinear", "scaled(SmoothTransformation)", [a, scaledSize] {
+        a.scaled(scaledSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }, static_cast<std::size_t>(scaledSize.width()) * scaledSize.height() * 4,
+       [a, scaledSize](ImageKernels const &kernels, std::uint8_t *out) {
+        kernels.resizeBilinear(constView(a), outputView(out, scaledSize), 0, scaledSize.height());
+    } });
+
+    result.push_back({ "convolve 3x3", nullptr, nullptr, imageBytes, [a, size](ImageKernels const &kernels, std::uint8_t *out) {
+        kernels.convolve3x3(constView(a), outputView(out, size), sharpen, 0, size.height());
+    } });
+
+    // sums far above 255 and below 0, as the convolution model allows coefficients up to ±100
+    result.push_back({ "convolve large", nullptr, nullptr, imageBytes, [a, size](ImageKernels const &kernels, std::uint8_t *out) {
+        kernels.convolve3x3(constView(a), outputView(out, size), saturating, 0, size.height());
+    } });
+
+    // the four channels of each pixel to four planes of width * height floats
+    result.push_back({ "unpack to float", "convertToFormat(Format_RGBA64)", [a] {
+        a.convertToFormat(QImage::Format_RGBA64);
+    }, imageBytes * sizeof(float), [a, size](ImageKernels const &kernels, std::uint8_t *out) {
+        auto planes = reinterpret_cast<float *>(out);
+        std::size_t const planeSize = static_cast<std::size_t>(size.width()) * size.height();
+
+        for (int y = 0; y < size.height(); ++y) {
+            std::size_t const offset = static_cast<std::size_t>(y) * size.width();
+            float *const rows[4] = { planes + offset, planes + planeSize + offset,
+                                     planes + 2 * planeSize + offset, planes + 3 * planeSize + offset };
+
+            kernels.unpackToFloat(a.constScanLine(y), 4, rows, size.width());
+        }
+    } });
+
+    // out of range values and NaN go through the clamping of every implementation
+    std::vector<float> floats(imageBytes);
+    std::mt19937 random(3);
+    std::uniform_real_distribution<float> value(-0.1f, 1.1f);
+
+    for (float &f : floats)
+        f = value(random);
+
+    floats[floats.size() / 2] = std::numeric_limits<float>::quiet_NaN();
+
+    QImage const wide = a.convertToFormat(QImage::Format_RGBA64);
+
+    result.push_back({ "pack from float", "convertToFormat(Format_ARGB32) from RGBA64", [wide] {
+        wide.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    }, imageBytes, [floats = std::move(floats), size](ImageKernels const &kernels, std::uint8_t *out) {
+        std::size_t const planeSize = static_cast<std::size_t>(size.width()) * size.height();
+
+        for (int y = 0; y < size.height(); ++y) {
+            std::size_t const offset = static_cast<std::size_t>(y) * size.width();
+            float const *const rows[4] = { floats.data() + offset, floats.data() + planeSize + offset,
+                                           floats.data() + 2 * planeSize + offset, floats.data() + 3 * planeSize + offset };
+
+            kernels.packFromFloat(rows, 4, out + offset * 4, size.width());
+        }
+    } });
+
+    return result;
+}
+
+//! 逐项比较标量与最快实现的结果，timed为真时还测量耗时。返回结果不同的项数
+static int run(QSize const &size, int repeat, bool timed)
+{
+    QImage const a = randomImage(size, 1);
+    QImage const b = randomImage(size, 2);
+
+    ImageKernels const &scalar = ImageKernels::scalar();
+    ImageKernels const &best = ImageKernels::best();
+
+    if (timed) {
+        std::printf("\n%dx%d, %d runs each, single thread\n", size.width(), size.height(), repeat);
+        std::printf("%-16s %10s %10s %10s %10s %10s  %s\n",
+                    "kernel", "QImage ms", "scalar ms", "best ms", "vs scalar", "vs QImage", "QImage operation");
+    }
+
+    int mismatches = 0;
+
+    for (Benchmark const &benchmark : benchmarks(a, b)) {
+        std::vector<std::uint8_t> scalarOut(benchmark.outputBytes);
+        std::vector<std::uint8_t> bestOut(benchmark.outputBytes);
+
+        // also warms the caches for the timed runs
+        benchmark.kernel(scalar, scalarOut.data());
+        benchmark.kernel(best, bestOut.data());
+
+        auto const difference = std::mismatch(scalarOut.begin(), scalarOut.end(), bestOut.begin());
+
+        if (difference.first != scalarOut.end()) {
+            ++mismatches;
+            std::fprintf(stderr, "%dx%d %s: %s differs from scalar at byte %td (%d != %d)\n",
+                         size.width(), size.height(), benchmark.name, best.name,
+                         difference.first - scalarOut.begin(), *difference.second, *difference.first);
+        }
+
+        if (!timed)
+            continue;
+
+        double const scalarMs = bestOf(repeat, [&] { benchmark.kernel(scalar, scalarOut.data()); });
+        double const bestMs = bestOf(repeat, [&] { benchmark.kernel(best, bestOut.data()); });
+
+        if (benchmark.qimage) {
+            double const qimageMs = bestOf(repeat, benchmark.qimage);
+
+            std::printf("%-16s %10.3f %10.3f %10.3f %9.2fx %9.2fx  %s\n",
+                        benchmark.name, qimageMs, scalarMs, bestMs,
+                        scalarMs / bestMs, qimageMs / bestMs, benchmark.baseline);
+        } else {
+            std::printf("%-16s %10s %10.3f %10.3f %9.2fx %10s  %s\n",
+                        benchmark.name, "-", scalarMs, bestMs, scalarMs / bestMs, "-", "-");
+        }
+    }
+
+    return mismatches;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("BmNodeEditorBench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Times the image kernels against QImage and checks that "
+                                     "every implementation gives the same bytes.");
+    parser.addHelpOption();
+
+    QCommandLineOption sizeOption({ "s", "size" }, "Image size to measure at, may be repeated.", "WxH");
+    QCommandLineOption repeatOption({ "n", "repeat" }, "Runs per measurement, the fastest is reported.", "count", "10");
+    QCommandLineOption checkOption("check", "Only compare the implementations, don't time them.");
+
+    parser.addOption(sizeOption);
+    parser.addOption(repeatOption);
+    parser.addOption(checkOption);
+    parser.process(app);
+
+    QStringList sizes = parser.values(sizeOption);
+    if (sizes.isEmpty())
+        sizes << "1920x1080" << "3840x2160";
+
+    int const repeat = std::max(parser.value(repeatOption).toInt(), 1);
+    bool const timed = !parser.isSet(checkOption);
+
+    std::printf("kernels: %s\n", ImageKernels::best().name);
+
+    // widths which aren't a multiple of any vector width go through the tails
+    int mismatches = run(QSize(131, 77), 1, false);
+
+    for (QString const &size : sizes) {
+        QStringList const parts = size.split('x');
+
+        int const width = parts.size() == 2 ? parts[0].toInt() : 0;
+        int const height = parts.size() == 2 ? parts[1].toInt() : 0;
+
+        if (width <= 0 || height <= 0) {
+            std::fprintf(stderr, "Invalid size %s, expected WxH\n", qPrintable(size));
+            return 1;
+        }
+
+        mismatches += run(QSize(width, height), repeat, timed);
+    }
+
+    if (mismatches > 0) {
+        std::fprintf(stderr, "%d results differ from the scalar kernels\n", mismatches);
+        return 1;
+    }
+
+    std::printf("\nall implementations give the same bytes\n");
+
+    return 0;
+}
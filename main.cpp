@@ -1,25 +1,15 @@
 #include "nodedata.h"
 #include "flowscene.h"
 #include "flowview.h"
-#include "imageloadermodel.h"
-#include "imageshowmodel.h"
+#include "imagemodels.h"
 
 #include <QApplication>
 
-static std::shared_ptr<DataModelRegistry> registerDataModels()
-{
-    auto ret = std::make_shared<DataModelRegistry>();
-    ret->registerModel<ImageShowModel>();
-    ret->registerModel<ImageLoaderModel>();
-
-    return ret;
-}
-
 int main(int argc, char *argv[])
 {
     QApplication app(argc, argv);
 
-    FlowScene scene(registerDataModels());
+    FlowScene scene(registerImageModels());
     FlowView view(&scene);
 
     view.setWindowTitle("Node-based flow editor");
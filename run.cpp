@@ -0,0 +1,204 @@
+#include "nodedata.h"
+#include "flowgraph.h"
+#include "node.h"
+#include "connection.h"
+#include "nodedatamodel.h"
+#include "imagemodels.h"
+#include "imageloadermodel.h"
+#include "imagedata.h"
+#include "tiledimagedata.h"
+#include "pixmapdata.h"
+
+#include <cstdio>
+#include <stdexcept>
+#include <vector>
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSignalBlocker>
+
+//! 没有下游连接的节点视为汇点：写出其输出，没有输出端口时写出其输入。返回写出的文件数
+static int writeSinks(FlowGraph &graph, QDir const &dir, int run)
+{
+    int written = 0;
+
+    for (Node *node : graph.allNodes()) {
+        bool hasDownstream = false;
+        for (auto const &connections : node->nodeState().getEntries(PortType::Out))
+            hasDownstream = hasDownstream || !connections.empty();
+
+        if (hasDownstream)
+            continue;
+
+        std::vector<std::shared_ptr<NodeData>> data;
+
+        unsigned int const nOutPorts = node->nodeDataModel()->nPorts(PortType::Out);
+
+        if (nOutPorts > 0) {
+            for (unsigned int i = 0; i < nOutPorts; ++i)
+                data.push_back(node->outData(static_cast<PortIndex>(i)));
+        } else {
+            for (auto const &connections : node->nodeState().getEntries(PortType::In)) {
+                for (auto const &pair : connections) {
+                    Connection const &connection = *pair.second;
+
+                    auto nodeData = connection.getNode(PortType::Out)->outData(connection.getPortIndex(PortType::Out));
+                    if (connection.typeConverter())
+                        nodeData = connection.typeConverter()(nodeData);
+
+                    data.push_back(std::move(nodeData));
+                }
+            }
+        }
+
+        for (std::size_t i = 0; i < data.size(); ++i) {
+            QImage image = imageFromData(data[i]);
+            if (auto pixmapData = std::dynamic_pointer_cast<PixmapData>(data[i]))
+                image = pixmapData->pixmap().toImage();
+
+            if (image.isNull())
+                continue;
+
+            QString const fileName =
+                    dir.filePath(QString("run%1_%2_%3.png")
+                                 .arg(run)
+                                 .arg(node->id().toString(QUuid::WithoutBraces))
+                                 .arg(i));
+
+            if (image.save(fileName))
+                ++written;
+            else
+                std::fprintf(stderr, "Cannot write %s\n", qPrintable(fileName));
+        }
+    }
+
+    return written;
+}
+
+int main(int argc, char *argv[])
+{
+    // The models embed widgets and pass QPixmaps around, which needs a GUI
+    // platform; render offscreen unless told otherwise.
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication app(argc, argv);
+    QApplication::setApplicationName("BmNodeEditorRun");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Executes a .flow graph without the editor.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("flow", "The .flow file to execute.");
+    parser.addPositionalArgument("inputs", "Images fed to the image sources, one run per image.", "[inputs...]");
+
+    QCommandLineOption outputOption({ "o", "output" }, "Directory the sink outputs are written to.", "dir", ".");
+    QCommandLineOption repeatOption({ "n", "repeat" }, "Number of runs when no inputs are given.", "count", "1");
+    QCommandLineOption serialOption("serial", "Evaluate the nodes one after another on the main thread.");
+    QCommandLineOption compiledOption("compiled", "Compile the graph once and run the execution plan on the main thread.");
+
+    parser.addOption(outputOption);
+    parser.addOption(repeatOption);
+    parser.addOption(serialOption);
+    parser.addOption(compiledOption);
+    parser.process(app);
+
+    QStringList inputs = parser.positionalArguments();
+    if (inputs.isEmpty())
+        parser.showHelp(1);
+
+    QString const flowFileName = inputs.takeFirst();
+
+    QFile flowFile(flowFileName);
+    if (!flowFile.open(QIODevice::ReadOnly)) {
+        std::fprintf(stderr, "Cannot open %s\n", qPrintable(flowFileName));
+        return 1;
+    }
+
+    QDir const outputDir(parser.value(outputOption));
+    if (!outputDir.exists() && !QDir().mkpath(outputDir.path())) {
+        std::fprintf(stderr, "Cannot create %s\n", qPrintable(outputDir.path()));
+        return 1;
+    }
+
+    FlowGraph graph(registerImageModels());
+
+    QElapsedTimer timer;
+    timer.start();
+
+    try {
+        graph.loadFromMemory(flowFile.readAll());
+    } catch (std::logic_error const &e) {
+        std::fprintf(stderr, "Cannot load %s: %s\n", qPrintable(flowFileName), e.what());
+        return 1;
+    }
+
+    std::printf("loaded %s: %zu nodes, %zu connections in %.3f ms\n",
+                qPrintable(flowFileName), graph.nodes().size(), graph.connections().size(),
+                timer.nsecsElapsed() / 1e6);
+
+    std::vector<ImageLoaderModel *> sources;
+    graph.iterateOverNodeData([&](NodeDataModel *model) {
+        if (auto source = qobject_cast<ImageLoaderModel *>(model))
+            sources.push_back(source);
+    });
+
+    if (!inputs.isEmpty() && sources.empty()) {
+        std::fprintf(stderr, "The graph has no image source to feed the inputs to\n");
+        return 1;
+    }
+
+    // restore() only starts decoding a preview in the background, the graph
+    // is executed right away and needs the full resolution images now
+    if (inputs.isEmpty()) {
+        for (ImageLoaderModel *source : sources) {
+            if (source->fileName().isEmpty())
+                continue;
+
+            QSignalBlocker blocker(source);
+            source->loadFile(source->fileName());
+        }
+    }
+
+    int const runs = inputs.isEmpty() ? qMax(parser.value(repeatOption).toInt(), 1) : inputs.size();
+    bool const parallel = !parser.isSet(serialOption);
+    bool const compiled = parser.isSet(compiledOption);
+
+    ExecutionPlan plan;
+    if (compiled)
+        plan = graph.compile();
+
+    double totalMs = 0.0;
+
+    for (int run = 0; run < runs; ++run) {
+        if (!inputs.isEmpty()) {
+            for (ImageLoaderModel *source : sources) {
+                // evaluate() below pushes the new image through the graph
+                QSignalBlocker blocker(source);
+                source->loadFile(inputs[run]);
+            }
+        }
+
+        timer.restart();
+        if (compiled)
+            plan.run();
+        else
+            graph.evaluate(parallel);
+        double const ms = timer.nsecsElapsed() / 1e6;
+
+        if (compiled)
+            plan.sync();
+
+        totalMs += ms;
+
+        int const written = writeSinks(graph, outputDir, run);
+
+        std::printf("run %d: %.3f ms, %d outputs written\n", run, ms, written);
+    }
+
+    std::printf("%d runs: %.3f ms total, %.3f ms per run\n", runs, totalMs, totalMs / runs);
+
+    return 0;
+}
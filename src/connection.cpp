@@ -5,7 +5,6 @@
 #include <QtWidgets>
 #include <QtGlobal>
 #include "node.h"
-#include "flowscene.h"
 #include "flowview.h"
 #include "nodegeometry.h"
 #include "nodegraphicsobject.h"
@@ -18,7 +17,8 @@ Connection::Connection(PortType portType, Node &node, PortIndex portIndex)
     : m_uuid_(QUuid::createUuid()),
       _outPortIndex(INVALID),
       _inPortIndex(INVALID),
-      _connectionState()
+      _connectionState(),
+      _stream(std::make_shared<StreamChannel>())
 {
     setNodeToPort(node, portType, portIndex);
     setRequiredPort(oppositePort(portType));
@@ -36,7 +36,8 @@ Connection::Connection(Node &nodeIn,
       _outPortIndex(portIndexOut),
       _inPortIndex(portIndexIn),
       _connectionState(),
-      _converter(std::move(typeConverter))
+      _converter(std::move(typeConverter)),
+      _stream(std::make_shared<StreamChannel>())
 {
     setNodeToPort(nodeIn, PortType::In, portIndexIn);
     setNodeToPort(nodeOut, PortType::Out, portIndexOut);
@@ -45,17 +46,22 @@ Connection::Connection(Node &nodeIn,
 
 Connection::~Connection()
 {
+    // wakes up producers blocked on a full queue
+    _stream->close();
+
     if (complete()) {
         connectionMadeIncomplete(*this);
     }
 
-    if (_inNode) {
+    if (_inNode && _inNode->hasGraphicsObject()) {
         _inNode->nodeGraphicsObject().update();
     }
 
     if (_outNode) {
         propagateEmptyData();
-        _outNode->nodeGraphicsObject().update();
+
+        if (_outNode->hasGraphicsObject())
+            _outNode->nodeGraphicsObject().update();
     }
 }
 
@@ -212,6 +218,11 @@ void Connection::removeFromNodes() const
         _outNode->nodeState().eraseConnection(PortType::Out, _outPortIndex, id());
 }
 
+bool Connection::hasGraphicsObject() const
+{
+    return _connectionGraphicsObject != nullptr;
+}
+
 ConnectionGraphicsObject &Connection::getConnectionGraphicsObject() const
 {
     return *_connectionGraphicsObject;
@@ -326,6 +337,16 @@ void Connection::setTypeConverter(TypeConverter converter)
     _converter = std::move(converter);
 }
 
+TypeConverter const &Connection::typeConverter() const
+{
+    return _converter;
+}
+
+std::shared_ptr<StreamChannel> const &Connection::stream() const
+{
+    return _stream;
+}
+
 void Connection::propagateData(std::shared_ptr<NodeData> nodeData) const
 {
     if (_inNode) {
@@ -0,0 +1,20 @@
+#include "coroutinenodedatamodel.h"
+
+void CoroutineNodeDataModel::setInData(std::shared_ptr<NodeData> nodeData, PortIndex port)
+{
+    restart();
+    coSetInData(std::move(nodeData), port);
+}
+
+NodeTask CoroutineNodeDataModel::coSetInData(std::shared_ptr<NodeData>, PortIndex)
+{
+    co_return;
+}
+
+CancellationToken const &CoroutineNodeDataModel::restart()
+{
+    cancellationToken().cancel();
+    setCancellationToken(CancellationToken());
+
+    return cancellationToken();
+}
@@ -0,0 +1,57 @@
+#include "executionplan.h"
+
+#include "node.h"
+#include "nodedatamodel.h"
+
+ExecutionPlan::ExecutionPlan(std::vector<Step> steps)
+    : _steps(std::move(steps))
+{}
+
+std::vector<ExecutionPlan::Step> const &ExecutionPlan::steps() const
+{
+    return _steps;
+}
+
+bool ExecutionPlan::empty() const
+{
+    return _steps.empty();
+}
+
+void ExecutionPlan::run() const
+{
+    for (Step const &step : _steps) {
+        if (step.inputs.empty())
+            continue;
+
+        // the next steps read the result directly, dataUpdated must not
+        // push it down the connections a second time
+        bool const signalsBlocked = step.model->blockSignals(true);
+
+        for (Input const &input : step.inputs) {
+            auto nodeData = _steps[input.sourceStep].model->outData(input.sourcePort);
+
+            if (input.converter)
+                nodeData = input.converter(std::move(nodeData));
+
+            step.model->setInData(std::move(nodeData), input.port, input.connectionId);
+        }
+
+        step.model->blockSignals(signalsBlocked);
+    }
+}
+
+void ExecutionPlan::sync() const
+{
+    for (Step const &step : _steps) {
+        for (Input const &input : step.inputs) {
+            auto nodeData = _steps[input.sourceStep].model->outData(input.sourcePort);
+
+            if (input.converter)
+                nodeData = input.converter(std::move(nodeData));
+
+            step.node->inputDelivered(std::move(nodeData), input.port, input.connectionId);
+        }
+
+        step.node->recalculateVisuals();
+    }
+}
@@ -0,0 +1,834 @@
+#include "flowgraph.h"
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <QByteArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QtGlobal>
+
+#include "node.h"
+#include "connection.h"
+#include "datamodelregistry.h"
+#include "computetask.h"
+
+namespace {
+
+//! 以整数下标表示的图快照，successors中的重复项对应两节点间的多条连接
+struct GraphSnapshot
+{
+    std::vector<Node *> nodes;
+    std::vector<std::vector<int>> successors;
+    std::vector<int> inDegree;
+};
+
+GraphSnapshot makeGraphSnapshot(std::unordered_map<QUuid, std::unique_ptr<Node>> const &nodes)
+{
+    GraphSnapshot snapshot;
+    snapshot.nodes.reserve(nodes.size());
+
+    std::unordered_map<Node const *, int> indices;
+    indices.reserve(nodes.size());
+
+    for (auto const &pair : nodes) {
+        indices[pair.second.get()] = static_cast<int>(snapshot.nodes.size());
+        snapshot.nodes.push_back(pair.second.get());
+    }
+
+    snapshot.successors.resize(snapshot.nodes.size());
+    snapshot.inDegree.assign(snapshot.nodes.size(), 0);
+
+    for (std::size_t i = 0; i < snapshot.nodes.size(); ++i) {
+        auto const &entries = snapshot.nodes[i]->nodeState().getEntries(PortType::Out);
+
+        for (auto const &connections : entries) {
+            for (auto const &pair : connections) {
+                // the connection may still be dragged by the user
+                Node *inNode = pair.second->getNode(PortType::In);
+                if (inNode == nullptr)
+                    continue;
+
+                int const j = indices.at(inNode);
+                snapshot.successors[i].push_back(j);
+                ++snapshot.inDegree[j];
+            }
+        }
+    }
+
+    return snapshot;
+}
+
+struct EvaluationInput
+{
+    std::shared_ptr<NodeData> data;
+    PortIndex port;
+    QUuid connectionId;
+};
+
+//! 读取所有输入连接上游的输出数据并记录到节点（须在GUI线程中调用）
+std::vector<EvaluationInput> collectInputs(Node &node)
+{
+    std::vector<EvaluationInput> inputs;
+
+    auto const &entries = node.nodeState().getEntries(PortType::In);
+
+    for (std::size_t port = 0; port < entries.size(); ++port) {
+        for (auto const &pair : entries[port]) {
+            Connection const *connection = pair.second;
+
+            Node *outNode = connection->getNode(PortType::Out);
+            if (outNode == nullptr)
+                continue;
+
+            auto nodeData = outNode->outData(connection->getPortIndex(PortType::Out));
+
+            if (connection->typeConverter())
+                nodeData = connection->typeConverter()(nodeData);
+
+            node.inputDelivered(nodeData, static_cast<PortIndex>(port), connection->id());
+
+            inputs.push_back({ std::move(nodeData), static_cast<PortIndex>(port), connection->id() });
+        }
+    }
+
+    return inputs;
+}
+
+void applyInputs(NodeDataModel &model, std::vector<EvaluationInput> const &inputs)
+{
+    for (auto const &input : inputs)
+        model.setInData(input.data, input.port, input.connectionId);
+}
+
+//! 并行求值。调度与输入读取都在当前线程中进行，工作线程只执行异步模型的setInData；
+//! 节点的所有前驱完成后立即被派发
+void evaluateParallel(GraphSnapshot const &snapshot, QThreadPool &threadPool)
+{
+    struct Finished
+    {
+        QMutex mutex;
+        QWaitCondition condition;
+        std::vector<int> nodes;
+    };
+
+    auto finished = std::make_shared<Finished>();
+
+    std::vector<int> inDegree = snapshot.inDegree;
+    std::vector<int> ready;
+
+    for (std::size_t i = 0; i < inDegree.size(); ++i) {
+        if (inDegree[i] == 0)
+            ready.push_back(static_cast<int>(i));
+    }
+
+    std::size_t remaining = snapshot.nodes.size();
+
+    while (remaining > 0) {
+        std::vector<int> local;
+
+        // start the pool jobs first so that they overlap with the local work
+        for (int i : ready) {
+            NodeDataModel *model = snapshot.nodes[i]->nodeDataModel();
+
+            if (!model->asyncCompute()) {
+                local.push_back(i);
+                continue;
+            }
+
+            auto inputs = collectInputs(*snapshot.nodes[i]);
+
+            threadPool.start(new ComputeTask([finished, model, inputs, i]()
+            {
+                applyInputs(*model, inputs);
+
+                QMutexLocker locker(&finished->mutex);
+                finished->nodes.push_back(i);
+                finished->condition.wakeOne();
+            }));
+        }
+
+        ready.clear();
+
+        for (int i : local) {
+            applyInputs(*snapshot.nodes[i]->nodeDataModel(), collectInputs(*snapshot.nodes[i]));
+
+            QMutexLocker locker(&finished->mutex);
+            finished->nodes.push_back(i);
+        }
+
+        std::vector<int> done;
+
+        {
+            QMutexLocker locker(&finished->mutex);
+            while (finished->nodes.empty())
+                finished->condition.wait(&finished->mutex);
+
+            done.swap(finished->nodes);
+        }
+
+        for (int i : done) {
+            --remaining;
+
+            for (int j : snapshot.successors[i]) {
+                if (--inDegree[j] == 0)
+                    ready.push_back(j);
+            }
+        }
+    }
+}
+
+}
+
+FlowGraph::FlowGraph(std::shared_ptr<DataModelRegistry> registry, QObject *parent)
+    : QObject(parent),
+      _registry(std::move(registry)),
+      _propagationMode(PropagationMode::Eager),
+      _dirtyEvaluationScheduled(false),
+      _evaluatingDirty(false),
+      _restrictToRequested(false),
+      _updateDepth(0),
+      _committingUpdate(false)
+{
+    // This connection should come first
+    connect(this, &FlowGraph::connectionCreated, this, &FlowGraph::setupConnectionSignals);
+    connect(this, &FlowGraph::connectionCreated, this, &FlowGraph::sendConnectionCreatedToNodes);
+    connect(this, &FlowGraph::connectionDeleted, this, &FlowGraph::sendConnectionDeletedToNodes);
+
+    connect(this, &FlowGraph::connectionCreated, this, &FlowGraph::insertConnectionIntoOrder);
+    connect(this, &FlowGraph::connectionDeleted, this, &FlowGraph::removeConnectionFromOrder);
+}
+
+FlowGraph::~FlowGraph()
+{
+    clear();
+}
+
+std::shared_ptr<Connection> FlowGraph::createConnection(PortType connectedPort,
+                                                        Node &node,
+                                                        PortIndex portIndex)
+{
+    auto connection = std::make_shared<Connection>(connectedPort, node, portIndex);
+
+    _connections[connection->id()] = connection;
+
+    // Note: this connection isn't truly created yet. It's only partially created.
+    // Thus, don't send the connectionCreated(...) signal.
+
+    connect(connection.get(),
+            &Connection::connectionCompleted,
+            this,
+            [this](Connection const &c) {
+        connectionCreated(c);
+    });
+
+    return connection;
+}
+
+std::shared_ptr<Connection> FlowGraph::createConnection(Node &nodeIn,
+                                                        PortIndex portIndexIn,
+                                                        Node &nodeOut,
+                                                        PortIndex portIndexOut,
+                                                        TypeConverter const &converter)
+{
+    if (_topologicalOrder.createsCycle(&nodeOut, &nodeIn))
+        throw std::logic_error("The connection would create a cycle");
+
+    auto connection =
+            std::make_shared<Connection>(nodeIn,
+                                         portIndexIn,
+                                         nodeOut,
+                                         portIndexOut,
+                                         converter);
+
+    nodeIn.nodeState().setConnection(PortType::In, portIndexIn, *connection);
+    nodeOut.nodeState().setConnection(PortType::Out, portIndexOut, *connection);
+
+    // trigger data propagation
+    nodeOut.onDataUpdated(portIndexOut);
+
+    _connections[connection->id()] = connection;
+
+    connectionCreated(*connection);
+
+    return connection;
+}
+
+std::shared_ptr<Connection> FlowGraph::restoreConnection(QJsonObject const &connectionJson)
+{
+    QUuid nodeInId  = QUuid(connectionJson["in_id"].toString());
+    QUuid nodeOutId = QUuid(connectionJson["out_id"].toString());
+
+    PortIndex portIndexIn  = connectionJson["in_index"].toInt();
+    PortIndex portIndexOut = connectionJson["out_index"].toInt();
+
+    auto nodeIn  = _nodes[nodeInId].get();
+    auto nodeOut = _nodes[nodeOutId].get();
+
+    auto getConverter = [&]()
+    {
+        QJsonValue converterVal = connectionJson["converter"];
+
+        if (!converterVal.isUndefined()) {
+            QJsonObject converterJson = converterVal.toObject();
+
+            NodeDataType inType { converterJson["in"].toObject()["id"].toString(),
+                        converterJson["in"].toObject()["name"].toString() };
+
+            NodeDataType outType { converterJson["out"].toObject()["id"].toString(),
+                        converterJson["out"].toObject()["name"].toString() };
+
+            auto converter  =
+                    registry().getTypeConverter(outType, inType);
+
+            if (converter)
+                return converter;
+        }
+
+        return TypeConverter{};
+    };
+
+    std::shared_ptr<Connection> connection =
+            createConnection(*nodeIn, portIndexIn,
+                             *nodeOut, portIndexOut,
+                             getConverter());
+
+    // Note: the connectionCreated(...) signal has already been sent
+    // by createConnection(...)
+
+    return connection;
+}
+
+void FlowGraph::deleteConnection(Connection const &connection)
+{
+    auto it = _connections.find(connection.id());
+    if (it != _connections.end()) {
+        connection.removeFromNodes();
+        _connections.erase(it);
+    }
+}
+
+Node &FlowGraph::createNode(std::unique_ptr<NodeDataModel> &&dataModel)
+{
+    auto node = detail::make_unique<Node>(std::move(dataModel), *this);
+
+    auto nodePtr = node.get();
+    _nodes[node->id()] = std::move(node);
+    _topologicalOrder.addNode(nodePtr);
+
+    emit nodeCreated(*nodePtr);
+    return *nodePtr;
+}
+
+Node &FlowGraph::restoreNode(QJsonObject const &nodeJson)
+{
+    QString modelName = nodeJson["model"].toObject()["name"].toString();
+    auto dataModel = registry().create(modelName);
+
+    if (!dataModel)
+        throw std::logic_error(std::string("No registered model with name ") +
+                               modelName.toLocal8Bit().data());
+
+    auto node = detail::make_unique<Node>(std::move(dataModel), *this);
+    node->restore(nodeJson);
+
+    auto nodePtr = node.get();
+    _nodes[node->id()] = std::move(node);
+    _topologicalOrder.addNode(nodePtr);
+
+    emit nodePlaced(*nodePtr);
+    emit nodeCreated(*nodePtr);
+    return *nodePtr;
+}
+
+void FlowGraph::removeNode(Node &node)
+{
+    emit nodeDeleted(node);
+
+    for(auto portType: {PortType::In, PortType::Out}) {
+        auto nodeState = node.nodeState();
+        auto const &nodeEntries = nodeState.getEntries(portType);
+
+        for (auto &connections : nodeEntries) {
+            for (auto const &pair : connections)
+                deleteConnection(*pair.second);
+        }
+    }
+
+    _topologicalOrder.removeNode(&node);
+    _dirtyInputs.erase(&node);
+    _requestedNodes.erase(&node);
+    _deferredInputs.erase(&node);
+    _nodes.erase(node.id());
+}
+
+DataModelRegistry &FlowGraph::registry() const
+{
+    return *_registry;
+}
+
+void FlowGraph::setRegistry(std::shared_ptr<DataModelRegistry> registry)
+{
+    _registry = std::move(registry);
+}
+
+QThreadPool &FlowGraph::threadPool()
+{
+    return _threadPool;
+}
+
+NodeOutputCache &FlowGraph::outputCache()
+{
+    return _outputCache;
+}
+
+void FlowGraph::iterateOverNodes(std::function<void(Node *)> const &visitor)
+{
+    for (const auto &_node : _nodes) {
+        visitor(_node.second.get());
+    }
+}
+
+void FlowGraph::iterateOverNodeData(std::function<void(NodeDataModel *)> const &visitor)
+{
+    for (const auto &_node : _nodes) {
+        visitor(_node.second->nodeDataModel());
+    }
+}
+
+void FlowGraph::iterateOverNodeDataDependentOrder(std::function<void(NodeDataModel *)> const &visitor)
+{
+    for (Node *node : _topologicalOrder.nodes())
+        visitor(node->nodeDataModel());
+}
+
+void FlowGraph::evaluate(bool parallel)
+{
+    // Jobs started by the regular data propagation must not touch
+    // the models while they are evaluated here.
+    _threadPool.waitForDone();
+
+    std::vector<Node *> const nodes = _topologicalOrder.nodes();
+
+    // dataUpdated would otherwise push every result down the connections
+    // a second time; the evaluation already visits each node in order.
+    std::vector<bool> signalsBlocked(nodes.size());
+    for (std::size_t i = 0; i < nodes.size(); ++i)
+        signalsBlocked[i] = nodes[i]->nodeDataModel()->blockSignals(true);
+
+    if (parallel) {
+        evaluateParallel(makeGraphSnapshot(_nodes), _threadPool);
+    } else {
+        for (Node *node : nodes)
+            applyInputs(*node->nodeDataModel(), collectInputs(*node));
+    }
+
+    for (std::size_t i = 0; i < nodes.size(); ++i) {
+        nodes[i]->nodeDataModel()->blockSignals(signalsBlocked[i]);
+        nodes[i]->recalculateVisuals();
+    }
+}
+
+ExecutionPlan FlowGraph::compile() const
+{
+    std::vector<Node *> const nodes = _topologicalOrder.nodes();
+
+    std::unordered_map<Node *, std::size_t> stepIndex;
+    stepIndex.reserve(nodes.size());
+
+    std::vector<ExecutionPlan::Step> steps;
+    steps.reserve(nodes.size());
+
+    for (Node *node : nodes) {
+        ExecutionPlan::Step step { node, node->nodeDataModel(), {} };
+
+        auto const &entries = node->nodeState().getEntries(PortType::In);
+
+        for (std::size_t port = 0; port < entries.size(); ++port) {
+            for (auto const &pair : entries[port]) {
+                Connection const *connection = pair.second;
+
+                Node *outNode = connection->getNode(PortType::Out);
+                if (outNode == nullptr)
+                    continue;
+
+                step.inputs.push_back({ stepIndex.at(outNode),
+                                        connection->getPortIndex(PortType::Out),
+                                        static_cast<PortIndex>(port),
+                                        connection->id(),
+                                        connection->typeConverter() });
+            }
+        }
+
+        stepIndex.emplace(node, steps.size());
+        steps.push_back(std::move(step));
+    }
+
+    return ExecutionPlan(std::move(steps));
+}
+
+TopologicalOrder const &FlowGraph::topologicalOrder() const
+{
+    return _topologicalOrder;
+}
+
+FlowGraph::PropagationMode FlowGraph::propagationMode() const
+{
+    return _propagationMode;
+}
+
+void FlowGraph::setPropagationMode(PropagationMode mode)
+{
+    _propagationMode = mode;
+
+    // nodes left dirty by the previous mode are brought up to date
+    if (!_dirtyEvaluationScheduled && !_evaluatingDirty && !_dirtyInputs.empty()) {
+        _dirtyEvaluationScheduled = true;
+        QMetaObject::invokeMethod(this, &FlowGraph::evaluateDirty, Qt::QueuedConnection);
+    }
+}
+
+void FlowGraph::markDirty(Node &node, PortIndex index)
+{
+    for (auto const &pair : node.nodeState().connections(PortType::Out, index)) {
+        Node *inNode = pair.second->getNode(PortType::In);
+        if (inNode == nullptr)
+            continue;
+
+        auto &dirtyConnections = _dirtyInputs[inNode];
+
+        if (dirtyConnections.empty() && _evaluatingDirty && isRequested(inNode))
+            _dirtyQueue.emplace(_topologicalOrder.position(inNode), inNode);
+
+        if (std::find(dirtyConnections.begin(), dirtyConnections.end(), pair.first) == dirtyConnections.end())
+            dirtyConnections.push_back(pair.first);
+    }
+
+    if (!_dirtyEvaluationScheduled && !_evaluatingDirty && !_dirtyInputs.empty()) {
+        _dirtyEvaluationScheduled = true;
+        QMetaObject::invokeMethod(this, &FlowGraph::evaluateDirty, Qt::QueuedConnection);
+    }
+}
+
+void FlowGraph::evaluateDirty()
+{
+    if (_evaluatingDirty)
+        return;
+
+    _dirtyEvaluationScheduled = false;
+
+    if (_propagationMode == PropagationMode::Pull) {
+        std::vector<Node *> sinks;
+
+        for (auto const &pair : _nodes) {
+            if (pair.second->nodeDataModel()->activeSink())
+                sinks.push_back(pair.second.get());
+        }
+
+        requestUpstreamCone(sinks);
+    }
+
+    evaluateDirtyNodes();
+}
+
+void FlowGraph::requestInputs(Node &sink)
+{
+    if (_evaluatingDirty)
+        return;
+
+    requestUpstreamCone({ &sink });
+    evaluateDirtyNodes();
+}
+
+void FlowGraph::requestUpstreamCone(std::vector<Node *> const &sinks)
+{
+    _requestedNodes.clear();
+    _restrictToRequested = true;
+
+    std::vector<Node *> stack;
+
+    for (Node *sink : sinks) {
+        if (_requestedNodes.insert(sink).second)
+            stack.push_back(sink);
+    }
+
+    while (!stack.empty()) {
+        Node *node = stack.back();
+        stack.pop_back();
+
+        for (auto const &connections : node->nodeState().getEntries(PortType::In)) {
+            for (auto const &pair : connections) {
+                Node *outNode = pair.second->getNode(PortType::Out);
+
+                if (outNode != nullptr && _requestedNodes.insert(outNode).second)
+                    stack.push_back(outNode);
+            }
+        }
+    }
+}
+
+bool FlowGraph::isRequested(Node *node) const
+{
+    return !_restrictToRequested || _requestedNodes.count(node) > 0;
+}
+
+void FlowGraph::evaluateDirtyNodes()
+{
+    _evaluatingDirty = true;
+
+    // dirty nodes outside the requested cone stay dirty until requested
+    _dirtyQueue.clear();
+    for (auto const &pair : _dirtyInputs) {
+        if (isRequested(pair.first))
+            _dirtyQueue.emplace(_topologicalOrder.position(pair.first), pair.first);
+    }
+
+    // Every upstream node has a smaller position, so all the dirty
+    // connections of a node are known by the time it is dequeued.
+    while (!_dirtyQueue.empty()) {
+        Node *node = _dirtyQueue.begin()->second;
+        _dirtyQueue.erase(_dirtyQueue.begin());
+
+        auto it = _dirtyInputs.find(node);
+        if (it == _dirtyInputs.end())
+            continue;
+
+        std::vector<QUuid> const connectionIds = std::move(it->second);
+        _dirtyInputs.erase(it);
+
+        for (QUuid const &id : connectionIds) {
+            auto c = _connections.find(id);
+            if (c == _connections.end() || !c->second->complete())
+                continue;
+
+            Connection const &connection = *c->second;
+
+            auto nodeData = connection.getNode(PortType::Out)->outData(connection.getPortIndex(PortType::Out));
+
+            if (connection.typeConverter())
+                nodeData = connection.typeConverter()(nodeData);
+
+            node->propagateData(std::move(nodeData), connection.getPortIndex(PortType::In), id);
+        }
+    }
+
+    _requestedNodes.clear();
+    _restrictToRequested = false;
+    _evaluatingDirty = false;
+}
+
+void FlowGraph::beginUpdate()
+{
+    ++_updateDepth;
+}
+
+void FlowGraph::endUpdate()
+{
+    Q_ASSERT(_updateDepth > 0);
+
+    if (_updateDepth > 1 || _committingUpdate) {
+        --_updateDepth;
+        return;
+    }
+
+    // The transaction stays open while committing: data pushed by the
+    // delivered nodes is deferred again and joins the queue, so every
+    // downstream node is still delivered only once.
+    _committingUpdate = true;
+
+    _deferredQueue.clear();
+    for (auto const &pair : _deferredInputs)
+        _deferredQueue.emplace(_topologicalOrder.position(pair.first), pair.first);
+
+    while (!_deferredQueue.empty()) {
+        Node *node = _deferredQueue.begin()->second;
+        _deferredQueue.erase(_deferredQueue.begin());
+
+        auto it = _deferredInputs.find(node);
+        if (it == _deferredInputs.end())
+            continue;
+
+        std::vector<DeferredInput> inputs = std::move(it->second);
+        _deferredInputs.erase(it);
+
+        for (auto &input : inputs)
+            node->deliverData(std::move(input.data), input.port, input.connectionId);
+    }
+
+    _committingUpdate = false;
+    --_updateDepth;
+}
+
+bool FlowGraph::deferPropagation(Node &node,
+                                 std::shared_ptr<NodeData> &nodeData,
+                                 PortIndex portIndex,
+                                 QUuid const &connectionId)
+{
+    if (_updateDepth == 0)
+        return false;
+
+    auto &inputs = _deferredInputs[&node];
+
+    if (inputs.empty() && _committingUpdate)
+        _deferredQueue.emplace(_topologicalOrder.position(&node), &node);
+
+    auto it = std::find_if(inputs.begin(), inputs.end(),
+                           [&](DeferredInput const &input)
+    {
+        return input.port == portIndex && input.connectionId == connectionId;
+    });
+
+    if (it != inputs.end())
+        it->data = std::move(nodeData);
+    else
+        inputs.push_back({ std::move(nodeData), portIndex, connectionId });
+
+    return true;
+}
+
+std::unordered_map<QUuid, std::unique_ptr<Node> > const &FlowGraph::nodes() const
+{
+    return _nodes;
+}
+
+std::unordered_map<QUuid, std::shared_ptr<Connection> > const &FlowGraph::connections() const
+{
+    return _connections;
+}
+
+std::vector<Node *> FlowGraph::allNodes() const
+{
+    std::vector<Node *> nodes;
+
+    std::transform(_nodes.begin(),
+                   _nodes.end(),
+                   std::back_inserter(nodes),
+                   [](std::pair<QUuid const, std::unique_ptr<Node>> const &p) { return p.second.get(); });
+
+    return nodes;
+}
+
+void FlowGraph::clear()
+{
+    PropagationBatch batch(*this);
+
+    //Manual node cleanup. Simply clearing the holding datastructures doesn't work, the code crashes when
+    // there are both nodes and connections in the graph. (The data propagation internal logic tries to propagate
+    // data through already freed connections.)
+    while (_connections.size() > 0) {
+        deleteConnection( *_connections.begin()->second );
+    }
+
+    while (_nodes.size() > 0) {
+        removeNode( *_nodes.begin()->second );
+    }
+}
+
+QByteArray FlowGraph::saveToMemory() const
+{
+    QJsonObject sceneJson;
+    QJsonArray nodesJsonArray;
+
+    for (auto const &pair : _nodes) {
+        auto const &node = pair.second;
+
+        nodesJsonArray.append(node->save());
+    }
+
+    sceneJson["nodes"] = nodesJsonArray;
+
+    QJsonArray connectionJsonArray;
+    for (auto const &pair : _connections) {
+        auto const &connection = pair.second;
+
+        QJsonObject connectionJson = connection->save();
+
+        if (!connectionJson.isEmpty())
+            connectionJsonArray.append(connectionJson);
+    }
+
+    sceneJson["connections"] = connectionJsonArray;
+
+    QJsonDocument document(sceneJson);
+
+    return document.toJson();
+}
+
+void FlowGraph::loadFromMemory(const QByteArray &data)
+{
+    // every restored connection pokes its output node, deliver it all once
+    PropagationBatch batch(*this);
+
+    QJsonObject const jsonDocument = QJsonDocument::fromJson(data).object();
+    QJsonArray nodesJsonArray = jsonDocument["nodes"].toArray();
+
+    for (QJsonValueRef node : nodesJsonArray) {
+        restoreNode(node.toObject());
+    }
+
+    QJsonArray connectionJsonArray = jsonDocument["connections"].toArray();
+
+    for (QJsonValueRef connection : connectionJsonArray) {
+        restoreConnection(connection.toObject());
+    }
+}
+
+void FlowGraph::setupConnectionSignals(Connection const &c)
+{
+    connect(&c,
+            &Connection::connectionMadeIncomplete,
+            this,
+            &FlowGraph::connectionDeleted,
+            Qt::UniqueConnection);
+}
+
+void FlowGraph::insertConnectionIntoOrder(Connection const &c)
+{
+    Node *from = c.getNode(PortType::Out);
+    Node *to   = c.getNode(PortType::In);
+
+    Q_ASSERT(from != nullptr);
+    Q_ASSERT(to != nullptr);
+
+    // cycles are rejected by createConnection and NodeConnectionInteraction
+    bool const acyclic = _topologicalOrder.addEdge(from, to);
+
+    Q_ASSERT(acyclic);
+    Q_UNUSED(acyclic);
+}
+
+void FlowGraph::removeConnectionFromOrder(Connection const &c)
+{
+    _topologicalOrder.removeEdge(c.getNode(PortType::Out), c.getNode(PortType::In));
+}
+
+void FlowGraph::sendConnectionCreatedToNodes(Connection const &c)
+{
+    Node *from = c.getNode(PortType::Out);
+    Node *to   = c.getNode(PortType::In);
+
+    Q_ASSERT(from != nullptr);
+    Q_ASSERT(to != nullptr);
+
+    from->nodeDataModel()->outputConnectionCreated(c);
+    to->nodeDataModel()->inputConnectionCreated(c);
+}
+
+void FlowGraph::sendConnectionDeletedToNodes(Connection const &c)
+{
+    Node *from = c.getNode(PortType::Out);
+    Node *to   = c.getNode(PortType::In);
+
+    Q_ASSERT(from != nullptr);
+    Q_ASSERT(to != nullptr);
+
+    from->nodeDataModel()->outputConnectionDeleted(c);
+    to->nodeDataModel()->inputConnectionDeleted(c);
+}
@@ -1,7 +1,8 @@
 #include "flowscene.h"
 
-#include <stdexcept>
+#include <memory>
 #include <utility>
+#include <vector>
 
 #include <QGraphicsSceneMoveEvent>
 #include <QFileDialog>
@@ -9,15 +10,12 @@
 #include <QBuffer>
 #include <QDataStream>
 #include <QFile>
-#include <QJsonDocument>
 #include <QJsonObject>
-#include <QJsonArray>
 #include <QtGlobal>
 #include <QDebug>
 
 #include "node.h"
 #include "nodegraphicsobject.h"
-#include "nodegraphicsobject.h"
 #include "connectiongraphicsobject.h"
 #include "connection.h"
 #include "flowview.h"
@@ -25,14 +23,16 @@
 
 FlowScene::FlowScene(std::shared_ptr<DataModelRegistry> registry, QObject *parent)
     : QGraphicsScene(parent),
-      _registry(registry)
+      _graph(std::move(registry))
 {
     setItemIndexMethod(QGraphicsScene::NoIndex);
 
-    // This connection should come first
-    connect(this, &FlowScene::connectionCreated, this, &FlowScene::setupConnectionSignals);
-    connect(this, &FlowScene::connectionCreated, this, &FlowScene::sendConnectionCreatedToNodes);
-    connect(this, &FlowScene::connectionDeleted, this, &FlowScene::sendConnectionDeletedToNodes);
+    // the graphics objects are created before the signals are passed on
+    connect(&_graph, &FlowGraph::nodeCreated, this, &FlowScene::onNodeCreated);
+    connect(&_graph, &FlowGraph::nodePlaced, this, &FlowScene::onNodePlaced);
+    connect(&_graph, &FlowGraph::nodeDeleted, this, &FlowScene::nodeDeleted);
+    connect(&_graph, &FlowGraph::connectionCreated, this, &FlowScene::onConnectionCreated);
+    connect(&_graph, &FlowGraph::connectionDeleted, this, &FlowScene::connectionDeleted);
 }
 
 FlowScene::FlowScene(QObject *parent)
@@ -45,28 +45,26 @@ FlowScene::~FlowScene()
     clearScene();
 }
 
+FlowGraph &FlowScene::graph()
+{
+    return _graph;
+}
+
+FlowGraph const &FlowScene::graph() const
+{
+    return _graph;
+}
+
 std::shared_ptr<Connection> FlowScene::createConnection(PortType connectedPort,
                                                         Node &node,
                                                         PortIndex portIndex)
 {
-    auto connection = std::make_shared<Connection>(connectedPort, node, portIndex);
+    auto connection = _graph.createConnection(connectedPort, node, portIndex);
     auto cgo = detail::make_unique<ConnectionGraphicsObject>(*this, *connection);
 
     // after this function connection points are set to node port
     connection->setGraphicsObject(std::move(cgo));
 
-    _connections[connection->id()] = connection;
-
-    // Note: this connection isn't truly created yet. It's only partially created.
-    // Thus, don't send the connectionCreated(...) signal.
-
-    connect(connection.get(),
-            &Connection::connectionCompleted,
-            this,
-            [this](Connection const &c) {
-        connectionCreated(c);
-    });
-
     return connection;
 }
 
@@ -76,223 +74,62 @@ std::shared_ptr<Connection> FlowScene::createConnection(Node &nodeIn,
                                                         PortIndex portIndexOut,
                                                         TypeConverter const &converter)
 {
-    auto connection =
-            std::make_shared<Connection>(nodeIn,
-                                         portIndexIn,
-                                         nodeOut,
-                                         portIndexOut,
-                                         converter);
-
-    auto cgo = detail::make_unique<ConnectionGraphicsObject>(*this, *connection);
-
-    nodeIn.nodeState().setConnection(PortType::In, portIndexIn, *connection);
-    nodeOut.nodeState().setConnection(PortType::Out, portIndexOut, *connection);
-
-    // after this function connection points are set to node port
-    connection->setGraphicsObject(std::move(cgo));
-
-    // trigger data propagation
-    nodeOut.onDataUpdated(portIndexOut);
-
-    _connections[connection->id()] = connection;
-
-    connectionCreated(*connection);
-
-    return connection;
+    return _graph.createConnection(nodeIn, portIndexIn, nodeOut, portIndexOut, converter);
 }
 
 std::shared_ptr<Connection> FlowScene::restoreConnection(QJsonObject const &connectionJson)
 {
-    QUuid nodeInId  = QUuid(connectionJson["in_id"].toString());
-    QUuid nodeOutId = QUuid(connectionJson["out_id"].toString());
-
-    PortIndex portIndexIn  = connectionJson["in_index"].toInt();
-    PortIndex portIndexOut = connectionJson["out_index"].toInt();
-
-    auto nodeIn  = _nodes[nodeInId].get();
-    auto nodeOut = _nodes[nodeOutId].get();
-
-    auto getConverter = [&]()
-    {
-        QJsonValue converterVal = connectionJson["converter"];
-
-        if (!converterVal.isUndefined()) {
-            QJsonObject converterJson = converterVal.toObject();
-
-            NodeDataType inType { converterJson["in"].toObject()["id"].toString(),
-                        converterJson["in"].toObject()["name"].toString() };
-
-            NodeDataType outType { converterJson["out"].toObject()["id"].toString(),
-                        converterJson["out"].toObject()["name"].toString() };
-
-            auto converter  =
-                    registry().getTypeConverter(outType, inType);
-
-            if (converter)
-                return converter;
-        }
-
-        return TypeConverter{};
-    };
-
-    std::shared_ptr<Connection> connection =
-            createConnection(*nodeIn, portIndexIn,
-                             *nodeOut, portIndexOut,
-                             getConverter());
-
-    // Note: the connectionCreated(...) signal has already been sent
-    // by createConnection(...)
-
-    return connection;
+    return _graph.restoreConnection(connectionJson);
 }
 
 void FlowScene::deleteConnection(Connection const &connection)
 {
-    auto it = _connections.find(connection.id());
-    if (it != _connections.end()) {
-        connection.removeFromNodes();
-        _connections.erase(it);
-    }
+    _graph.deleteConnection(connection);
 }
 
 Node &FlowScene::createNode(std::unique_ptr<NodeDataModel> &&dataModel)
 {
-    auto node = detail::make_unique<Node>(std::move(dataModel));
-    auto ngo  = detail::make_unique<NodeGraphicsObject>(*this, *node);
-
-    node->setGraphicsObject(std::move(ngo));
-
-    auto nodePtr = node.get();
-    _nodes[node->id()] = std::move(node);
-
-    emit nodeCreated(*nodePtr);
-    return *nodePtr;
+    return _graph.createNode(std::move(dataModel));
 }
 
 Node &FlowScene::restoreNode(QJsonObject const &nodeJson)
 {
-    QString modelName = nodeJson["model"].toObject()["name"].toString();
-    auto dataModel = registry().create(modelName);
-
-    if (!dataModel)
-        throw std::logic_error(std::string("No registered model with name ") +
-                               modelName.toLocal8Bit().data());
-
-    auto node = detail::make_unique<Node>(std::move(dataModel));
-    auto ngo  = detail::make_unique<NodeGraphicsObject>(*this, *node);
-    node->setGraphicsObject(std::move(ngo));
-    node->restore(nodeJson);
-
-    auto nodePtr = node.get();
-    _nodes[node->id()] = std::move(node);
-
-    emit nodePlaced(*nodePtr);
-    emit nodeCreated(*nodePtr);
-    return *nodePtr;
+    return _graph.restoreNode(nodeJson);
 }
 
 void FlowScene::removeNode(Node &node)
 {
-    emit nodeDeleted(node);
-
-    for(auto portType: {PortType::In, PortType::Out}) {
-        auto nodeState = node.nodeState();
-        auto const &nodeEntries = nodeState.getEntries(portType);
-
-        for (auto &connections : nodeEntries) {
-            for (auto const &pair : connections)
-                deleteConnection(*pair.second);
-        }
-    }
-
-    _nodes.erase(node.id());
+    _graph.removeNode(node);
 }
 
 DataModelRegistry &FlowScene::registry() const
 {
-    return *_registry;
+    return _graph.registry();
 }
 
 void FlowScene::setRegistry(std::shared_ptr<DataModelRegistry> registry)
 {
-    _registry = std::move(registry);
+    _graph.setRegistry(std::move(registry));
 }
 
 void FlowScene::iterateOverNodes(std::function<void(Node *)> const &visitor)
 {
-    for (const auto &_node : _nodes) {
-        visitor(_node.second.get());
-    }
+    _graph.iterateOverNodes(visitor);
 }
 
 void FlowScene::iterateOverNodeData(std::function<void(NodeDataModel *)> const &visitor)
 {
-    for (const auto &_node : _nodes) {
-        visitor(_node.second->nodeDataModel());
-    }
+    _graph.iterateOverNodeData(visitor);
 }
 
 void FlowScene::iterateOverNodeDataDependentOrder(std::function<void(NodeDataModel *)> const &visitor)
 {
-    std::set<QUuid> visitedNodesSet;
-
-    //A leaf node is a node with no input ports, or all possible input ports empty
-    auto isNodeLeaf =
-            [](Node const &node, NodeDataModel const &model)
-    {
-        for (unsigned int i = 0; i < model.nPorts(PortType::In); ++i) {
-            auto connections = node.nodeState().connections(PortType::In, i);
-            if (!connections.empty()) {
-                return false;
-            }
-        }
-
-        return true;
-    };
-
-    //Iterate over "leaf" nodes
-    for (auto const &_node : _nodes) {
-        auto const &node = _node.second;
-        auto model       = node->nodeDataModel();
-
-        if (isNodeLeaf(*node, *model)) {
-            visitor(model);
-            visitedNodesSet.insert(node->id());
-        }
-    }
-
-    auto areNodeInputsVisitedBefore =
-            [&](Node const &node, NodeDataModel const &model)
-    {
-        for (size_t i = 0; i < model.nPorts(PortType::In); ++i) {
-            auto connections = node.nodeState().connections(PortType::In, static_cast<PortIndex>(i));
-
-            for (auto &conn : connections) {
-                if (visitedNodesSet.find(conn.second->getNode(PortType::Out)->id()) == visitedNodesSet.end()) {
-                    return false;
-                }
-            }
-        }
-
-        return true;
-    };
-
-    //Iterate over dependent nodes
-    while (_nodes.size() != visitedNodesSet.size())
-    {
-        for (auto const &_node : _nodes) {
-            auto const &node = _node.second;
-            if (visitedNodesSet.find(node->id()) != visitedNodesSet.end())
-                continue;
-
-            auto model = node->nodeDataModel();
+    _graph.iterateOverNodeDataDependentOrder(visitor);
+}
 
-            if (areNodeInputsVisitedBefore(*node, *model)) {
-                visitor(model);
-                visitedNodesSet.insert(node->id());
-            }
-        }
-    }
+ExecutionPlan FlowScene::compile() const
+{
+    return _graph.compile();
 }
 
 QPointF FlowScene::getNodePosition(const Node &node) const
@@ -313,24 +150,17 @@ QSizeF FlowScene::getNodeSize(const Node &node) const
 
 std::unordered_map<QUuid, std::unique_ptr<Node> > const &FlowScene::nodes() const
 {
-    return _nodes;
+    return _graph.nodes();
 }
 
 std::unordered_map<QUuid, std::shared_ptr<Connection> > const &FlowScene::connections() const
 {
-    return _connections;
+    return _graph.connections();
 }
 
 std::vector<Node *> FlowScene::allNodes() const
 {
-    std::vector<Node *> nodes;
-
-    std::transform(_nodes.begin(),
-                   _nodes.end(),
-                   std::back_inserter(nodes),
-                   [](std::pair<QUuid const, std::unique_ptr<Node>> const &p) { return p.second.get(); });
-
-    return nodes;
+    return _graph.allNodes();
 }
 
 std::vector<Node *> FlowScene::selectedNodes() const
@@ -353,16 +183,7 @@ std::vector<Node *> FlowScene::selectedNodes() const
 
 void FlowScene::clearScene()
 {
-    //Manual node cleanup. Simply clearing the holding datastructures doesn't work, the code crashes when
-    // there are both nodes and connections in the scene. (The data propagation internal logic tries to propagate
-    // data through already freed connections.)
-    while (_connections.size() > 0) {
-        deleteConnection( *_connections.begin()->second );
-    }
-
-    while (_nodes.size() > 0) {
-        removeNode( *_nodes.begin()->second );
-    }
+    _graph.clear();
 }
 
 void FlowScene::save() const
@@ -405,81 +226,45 @@ void FlowScene::load()
 
 QByteArray FlowScene::saveToMemory() const
 {
-    QJsonObject sceneJson;
-    QJsonArray nodesJsonArray;
-
-    for (auto const &pair : _nodes) {
-        auto const &node = pair.second;
-
-        nodesJsonArray.append(node->save());
-    }
-
-    sceneJson["nodes"] = nodesJsonArray;
-
-    QJsonArray connectionJsonArray;
-    for (auto const &pair : _connections) {
-        auto const &connection = pair.second;
-
-        QJsonObject connectionJson = connection->save();
-
-        if (!connectionJson.isEmpty())
-            connectionJsonArray.append(connectionJson);
-    }
-
-    sceneJson["connections"] = connectionJsonArray;
-
-    QJsonDocument document(sceneJson);
-
-    return document.toJson();
+    return _graph.saveToMemory();
 }
 
 void FlowScene::loadFromMemory(const QByteArray &data)
 {
-    QJsonObject const jsonDocument = QJsonDocument::fromJson(data).object();
-    QJsonArray nodesJsonArray = jsonDocument["nodes"].toArray();
-
-    for (QJsonValueRef node : nodesJsonArray) {
-        restoreNode(node.toObject());
-    }
+    _graph.loadFromMemory(data);
+}
 
-    QJsonArray connectionJsonArray = jsonDocument["connections"].toArray();
+void FlowScene::attachGraphicsObject(Node &node)
+{
+    if (node.hasGraphicsObject())
+        return;
 
-    for (QJsonValueRef connection : connectionJsonArray) {
-        restoreConnection(connection.toObject());
-    }
+    node.setGraphicsObject(detail::make_unique<NodeGraphicsObject>(*this, node));
 }
 
-void FlowScene::setupConnectionSignals(Connection const &c)
+void FlowScene::onNodeCreated(Node &node)
 {
-    connect(&c,
-            &Connection::connectionMadeIncomplete,
-            this,
-            &FlowScene::connectionDeleted,
-            Qt::UniqueConnection);
+    attachGraphicsObject(node);
+
+    emit nodeCreated(node);
 }
 
-void FlowScene::sendConnectionCreatedToNodes(Connection const &c)
+void FlowScene::onNodePlaced(Node &node)
 {
-    Node *from = c.getNode(PortType::Out);
-    Node *to   = c.getNode(PortType::In);
+    attachGraphicsObject(node);
 
-    Q_ASSERT(from != nullptr);
-    Q_ASSERT(to != nullptr);
-
-    from->nodeDataModel()->outputConnectionCreated(c);
-    to->nodeDataModel()->inputConnectionCreated(c);
+    emit nodePlaced(node);
 }
 
-void FlowScene::sendConnectionDeletedToNodes(Connection const &c)
+void FlowScene::onConnectionCreated(Connection const &c)
 {
-    Node *from = c.getNode(PortType::Out);
-    Node *to   = c.getNode(PortType::In);
-
-    Q_ASSERT(from != nullptr);
-    Q_ASSERT(to != nullptr);
+    // connections dragged by the user already have one
+    if (!c.hasGraphicsObject()) {
+        auto const &connection = _graph.connections().at(c.id());
+        connection->setGraphicsObject(detail::make_unique<ConnectionGraphicsObject>(*this, *connection));
+    }
 
-    from->nodeDataModel()->outputConnectionDeleted(c);
-    to->nodeDataModel()->inputConnectionDeleted(c);
+    emit connectionCreated(c);
 }
 
 Node *locateNodeAt(QPointF scenePoint, FlowScene &scene,
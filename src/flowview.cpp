@@ -201,6 +201,8 @@ void FlowView::scaleDown()
 
 void FlowView::deleteSelectedNodes()
 {
+    PropagationBatch batch(_scene->graph());
+
     // Delete the selected connections first, ensuring that they won't be
     // automatically deleted when selected nodes are deleted (deleting a node
     // deletes some connections as well)
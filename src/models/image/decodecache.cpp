@@ -0,0 +1,182 @@
+#include "decodecache.h"
+
+#include <iterator>
+
+#include <QDateTime>
+#include <QFileInfo>
+#include <QHash>
+#include <QImageReader>
+
+DecodeCache &DecodeCache::instance()
+{
+    static DecodeCache cache;
+    return cache;
+}
+
+DecodeCache::DecodeCache()
+    : _byteBudget(512 * 1024 * 1024),
+      _byteSize(0),
+      _serial(0),
+      _hits(0),
+      _misses(0)
+{}
+
+QImage DecodeCache::decode(QString const &fileName, QSize const &maxSize)
+{
+    QImageReader reader(fileName);
+    reader.setAutoTransform(true);
+
+    QSize const size = reader.size();
+
+    // 解码器（JPEG等）可以直接解码出缩小的图片，不必先分配全分辨率的缓冲区
+    if (maxSize.isValid() && size.isValid() &&
+        (size.width() > maxSize.width() || size.height() > maxSize.height()))
+        reader.setScaledSize(size.scaled(maxSize, Qt::KeepAspectRatio));
+
+    return reader.read();
+}
+
+QImage DecodeCache::image(QString const &fileName, QSize const &maxSize)
+{
+    QFileInfo const info(fileName);
+    QString const path = info.canonicalFilePath();
+
+    // let the reader report the missing file
+    if (path.isEmpty())
+        return decode(fileName, maxSize);
+
+    Key const key { path, info.size(), info.lastModified().toMSecsSinceEpoch(), maxSize };
+
+    std::promise<QImage> promise;
+    std::shared_future<QImage> future;
+    quint64 serial;
+
+    {
+        QMutexLocker locker(&_mutex);
+
+        auto it = _index.find(key);
+
+        if (it != _index.end()) {
+            ++_hits;
+
+            _entries.splice(_entries.begin(), _entries, it->second);
+
+            // waits if another thread is still decoding it
+            future = it->second->image;
+            locker.unlock();
+
+            return future.get();
+        }
+
+        ++_misses;
+
+        // the file has changed since it was decoded
+        for (auto entry = _entries.begin(); entry != _entries.end();) {
+            auto const current = entry++;
+            if (current->key.path == path &&
+                (current->key.size != key.size || current->key.modified != key.modified))
+                erase(current);
+        }
+
+        future = promise.get_future().share();
+        serial = ++_serial;
+
+        _entries.push_front({ key, future, 0, serial });
+        _index.emplace(key, _entries.begin());
+    }
+
+    QImage const image = decode(fileName, maxSize);
+    promise.set_value(image);
+
+    QMutexLocker locker(&_mutex);
+
+    auto it = _index.find(key);
+
+    // evicted or cleared while decoding
+    if (it == _index.end() || it->second->serial != serial)
+        return image;
+
+    if (image.isNull()) {
+        erase(it->second);
+    } else {
+        it->second->bytes = static_cast<std::size_t>(image.sizeInBytes());
+        _byteSize += it->second->bytes;
+
+        evict();
+    }
+
+    return image;
+}
+
+void DecodeCache::clear()
+{
+    QMutexLocker locker(&_mutex);
+
+    _index.clear();
+    _entries.clear();
+    _byteSize = 0;
+}
+
+std::size_t DecodeCache::byteBudget() const
+{
+    QMutexLocker locker(&_mutex);
+    return _byteBudget;
+}
+
+void DecodeCache::setByteBudget(std::size_t bytes)
+{
+    QMutexLocker locker(&_mutex);
+
+    _byteBudget = bytes;
+    evict();
+}
+
+std::size_t DecodeCache::byteSize() const
+{
+    QMutexLocker locker(&_mutex);
+    return _byteSize;
+}
+
+std::size_t DecodeCache::hits() const
+{
+    QMutexLocker locker(&_mutex);
+    return _hits;
+}
+
+std::size_t DecodeCache::misses() const
+{
+    QMutexLocker locker(&_mutex);
+    return _misses;
+}
+
+std::size_t DecodeCache::KeyHash::operator()(Key const &key) const
+{
+    std::size_t seed = qHash(key.path);
+
+    for (qint64 value : { key.size, key.modified, qint64(key.maxSize.width()), qint64(key.maxSize.height()) })
+        seed ^= static_cast<std::size_t>(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+
+    return seed;
+}
+
+void DecodeCache::erase(EntryList::iterator it)
+{
+    _byteSize -= it->bytes;
+    _index.erase(it->key);
+    _entries.erase(it);
+}
+
+void DecodeCache::evict()
+{
+    // entries still being decoded hold no bytes yet and are kept
+    auto it = _entries.end();
+
+    while (_byteSize > _byteBudget && it != _entries.begin()) {
+        auto const current = std::prev(it);
+
+        if (current->bytes > 0)
+            erase(current);
+        else
+            it = current;
+    }
+}
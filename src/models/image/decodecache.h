@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <future>
+#include <list>
+#include <unordered_map>
+
+#include <QImage>
+#include <QMutex>
+#include <QSize>
+#include <QString>
+
+/**
+ * @brief 进程内共享的图片解码缓存，按字节预算LRU淘汰
+ *
+ * 以规范路径、文件大小、修改时间及解码尺寸为键：多个节点读取同一文件时共享
+ * 同一块解码后的缓冲区（QImage隐式共享），重新加载场景也不必再次解码；
+ * 文件被修改后键随之改变，旧的解码结果被丢弃。
+ * 同一文件同时被多个线程请求时只解码一次，其余线程等待其结果。线程安全
+ */
+class DecodeCache
+{
+public:
+    static DecodeCache &instance();
+
+    DecodeCache();
+
+    //! 解码fileName（不经过缓存），maxSize有效时按比例缩小解码，不超过maxSize
+    static QImage decode(QString const &fileName, QSize const &maxSize = QSize());
+
+    //! 缓存中的解码结果，未命中时在调用线程中解码。解码失败的结果不缓存
+    QImage image(QString const &fileName, QSize const &maxSize = QSize());
+
+    void clear();
+
+    std::size_t byteBudget() const;
+    void setByteBudget(std::size_t bytes);
+
+    std::size_t byteSize() const;
+
+    std::size_t hits() const;
+    std::size_t misses() const;
+
+private:
+    struct Key
+    {
+        QString path;
+        qint64 size;
+        qint64 modified;
+        QSize maxSize;
+
+        friend bool operator==(Key const &k1, Key const &k2)
+        {
+            return k1.path == k2.path && k1.size == k2.size &&
+                   k1.modified == k2.modified && k1.maxSize == k2.maxSize;
+        }
+    };
+
+    struct KeyHash
+    {
+        std::size_t operator()(Key const &key) const;
+    };
+
+    struct Entry
+    {
+        Key key;
+        std::shared_future<QImage> image;
+
+        //! 解码完成前为0
+        std::size_t bytes;
+
+        //! 区分被淘汰后以同一键重新加入的条目
+        quint64 serial;
+    };
+
+    using EntryList = std::list<Entry>;
+
+    void erase(EntryList::iterator it);
+    void evict();
+
+private:
+    mutable QMutex _mutex;
+
+    // most recently used first
+    EntryList _entries;
+    std::unordered_map<Key, EntryList::iterator, KeyHash> _index;
+
+    std::size_t _byteBudget;
+    std::size_t _byteSize;
+
+    quint64 _serial;
+
+    std::size_t _hits;
+    std::size_t _misses;
+};
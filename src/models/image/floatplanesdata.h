@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#include "nodedata.h"
+
+/**
+ * @brief 按通道分平面存储的浮点图片，值通常在[0, 1]内
+ *
+ * 通道数为1（灰度）、3（RGB）或4（RGBA，alpha不预乘），每个平面width * height个值，
+ * 各平面依次连续存放。数据传出后只读，复制FloatPlanesData共享同一块缓冲区
+ */
+class FloatPlanesData : public NodeData
+{
+public:
+    FloatPlanesData() {}
+
+    FloatPlanesData(int width, int height, int channels)
+        : _width(width),
+          _height(height),
+          _channels(channels),
+          _values(std::make_shared<Values>())
+    {
+        _values->data.resize(static_cast<std::size_t>(width) * height * channels);
+    }
+
+    NodeDataType type() const override
+    {
+        return { "float_planes", "F" };
+    }
+
+    bool isNull() const { return !_values; }
+    int width() const { return _width; }
+    int height() const { return _height; }
+    int channels() const { return _channels; }
+
+    float const *plane(int channel) const
+    {
+        return _values->data.data() + static_cast<std::size_t>(channel) * _width * _height;
+    }
+
+    //! 只能在数据传出前写入
+    float *plane(int channel)
+    {
+        return _values->data.data() + static_cast<std::size_t>(channel) * _width * _height;
+    }
+
+    //! 第一次调用时遍历所有值，之后直接返回（共享缓冲区的副本也不再计算）；线程安全
+    std::size_t hash() const override
+    {
+        if (!_values)
+            return 4;
+
+        std::call_once(_values->hashOnce, [this] {
+            std::string_view const bytes(reinterpret_cast<char const *>(_values->data.data()),
+                                         _values->data.size() * sizeof(float));
+
+            std::size_t seed = std::hash<std::string_view>()(bytes);
+            for (int value : { _width, _height, _channels })
+                seed ^= static_cast<std::size_t>(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+
+            _values->hash = seed != 0 ? seed : 4;
+        });
+
+        return _values->hash;
+    }
+
+    std::size_t byteSize() const override
+    {
+        return _values ? _values->data.size() * sizeof(float) : 0;
+    }
+
+private:
+    int _width = 0;
+    int _height = 0;
+    int _channels = 0;
+
+    struct Values
+    {
+        std::vector<float> data;
+
+        std::once_flag hashOnce;
+        std::size_t hash = 0;
+    };
+
+    std::shared_ptr<Values> _values;
+};
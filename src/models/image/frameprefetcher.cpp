@@ -0,0 +1,196 @@
+#include "frameprefetcher.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <QImageReader>
+#include <QMutex>
+#include <QThreadPool>
+
+#include "computetask.h"
+#include "imagedata.h"
+
+// Shared with the decode jobs, which may outlive the prefetcher.
+struct FramePrefetcher::State
+{
+    struct Slot
+    {
+        int frame = -1;
+        bool ready = false;
+        QImage image;
+        std::size_t hash = 0;
+    };
+
+    QStringList files;
+    ReadyFunction ready;
+
+    QMutex mutex;
+
+    std::vector<Slot> ring;
+
+    // bumped by seek() and the destructor, older jobs drop their result
+    quint64 generation = 0;
+
+    int next = 0;
+    int stalledFrame = -1;
+
+    std::size_t stalls = 0;
+    std::size_t decoded = 0;
+};
+
+FramePrefetcher::FramePrefetcher(QStringList files, int depth, ReadyFunction ready, int first)
+    : _state(std::make_shared<State>())
+{
+    _state->files = std::move(files);
+    _state->ready = std::move(ready);
+    _state->ring.resize(static_cast<std::size_t>(std::max(depth, 1)));
+
+    seek(first);
+}
+
+FramePrefetcher::~FramePrefetcher()
+{
+    QMutexLocker locker(&_state->mutex);
+    ++_state->generation;
+}
+
+int FramePrefetcher::frameCount() const
+{
+    return _state->files.size();
+}
+
+int FramePrefetcher::depth() const
+{
+    return static_cast<int>(_state->ring.size());
+}
+
+int FramePrefetcher::position() const
+{
+    QMutexLocker locker(&_state->mutex);
+    return _state->next;
+}
+
+bool FramePrefetcher::atEnd() const
+{
+    return position() >= frameCount();
+}
+
+void FramePrefetcher::seek(int frame)
+{
+    {
+        QMutexLocker locker(&_state->mutex);
+
+        ++_state->generation;
+
+        for (State::Slot &slot : _state->ring)
+            slot = State::Slot();
+
+        _state->next = frame;
+        _state->stalledFrame = -1;
+    }
+
+    for (int i = frame; i < std::min(frame + depth(), frameCount()); ++i)
+        schedule(i);
+}
+
+bool FramePrefetcher::take(QImage &image, std::size_t &hash, int &frame)
+{
+    int refill;
+
+    {
+        QMutexLocker locker(&_state->mutex);
+
+        if (_state->next >= frameCount())
+            return false;
+
+        State::Slot &slot = _state->ring[static_cast<std::size_t>(_state->next) % _state->ring.size()];
+
+        if (slot.frame != _state->next || !slot.ready) {
+            if (_state->stalledFrame != _state->next) {
+                _state->stalledFrame = _state->next;
+                ++_state->stalls;
+            }
+
+            return false;
+        }
+
+        image = std::move(slot.image);
+        hash = slot.hash;
+        frame = _state->next;
+
+        slot = State::Slot();
+
+        refill = _state->next + depth();
+        ++_state->next;
+    }
+
+    // the slot just freed takes the frame depth ahead
+    if (refill < frameCount())
+        schedule(refill);
+
+    return true;
+}
+
+int FramePrefetcher::buffered() const
+{
+    QMutexLocker locker(&_state->mutex);
+
+    return static_cast<int>(std::count_if(_state->ring.begin(), _state->ring.end(),
+                                          [](State::Slot const &slot) { return slot.ready; }));
+}
+
+std::size_t FramePrefetcher::stalls() const
+{
+    QMutexLocker locker(&_state->mutex);
+    return _state->stalls;
+}
+
+std::size_t FramePrefetcher::decoded() const
+{
+    QMutexLocker locker(&_state->mutex);
+    return _state->decoded;
+}
+
+void FramePrefetcher::schedule(int frame)
+{
+    quint64 generation;
+
+    {
+        QMutexLocker locker(&_state->mutex);
+
+        State::Slot &slot = _state->ring[static_cast<std::size_t>(frame) % _state->ring.size()];
+        slot.frame = frame;
+        slot.ready = false;
+
+        generation = _state->generation;
+    }
+
+    auto state = _state;
+    QString const fileName = _state->files[frame];
+
+    QThreadPool::globalInstance()->start(new ComputeTask([state, frame, generation, fileName] {
+        QImageReader reader(fileName);
+        reader.setAutoTransform(true);
+
+        QImage image = reader.read();
+        std::size_t const hash = imageContentHash(image, ImageData::HashSeed);
+
+        {
+            QMutexLocker locker(&state->mutex);
+
+            State::Slot &slot = state->ring[static_cast<std::size_t>(frame) % state->ring.size()];
+
+            if (state->generation != generation || slot.frame != frame)
+                return;
+
+            // an unreadable frame is passed on as a null image, playback goes on
+            slot.image = std::move(image);
+            slot.hash = hash;
+            slot.ready = true;
+
+            ++state->decoded;
+        }
+
+        state->ready();
+    }));
+}
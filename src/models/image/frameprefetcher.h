@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+#include <QImage>
+#include <QStringList>
+
+/**
+ * @brief 图片序列的预取环形缓冲区
+ *
+ * 缓冲区有depth个槽，第i帧解码到第i % depth个槽。取走一帧后立即在线程池中
+ * 解码其后第depth帧，因此解码始终领先消费最多depth帧。
+ * 要取的帧尚未解码完成时记为一次停顿（同一帧只记一次），
+ * 停顿次数与已缓冲的帧数可用于确定缓冲区大小。
+ *
+ * 除回调外所有方法在同一线程（GUI线程）中调用
+ */
+class FramePrefetcher
+{
+public:
+    //! 一帧解码完成（工作线程中调用）
+    using ReadyFunction = std::function<void()>;
+
+public:
+    //! 从first帧开始预取
+    FramePrefetcher(QStringList files, int depth, ReadyFunction ready, int first = 0);
+
+    //! 丢弃尚未完成的解码结果
+    ~FramePrefetcher();
+
+public:
+    int frameCount() const;
+    int depth() const;
+
+    //! 下一个要取的帧
+    int position() const;
+    bool atEnd() const;
+
+    //! 清空缓冲区，从frame开始重新预取
+    void seek(int frame);
+
+    //! 取出下一帧及其内容哈希（在解码的工作线程中算出），尚未解码完成时返回false
+    bool take(QImage &image, std::size_t &hash, int &frame);
+
+    //! 已解码、等待被取走的帧数
+    int buffered() const;
+
+    std::size_t stalls() const;
+    std::size_t decoded() const;
+
+private:
+    struct State;
+
+    void schedule(int frame);
+
+private:
+    std::shared_ptr<State> _state;
+};
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string_view>
+
+#include <QImage>
+
+#include "nodedata.h"
+#include "imagepyramid.h"
+
+//! 图片的内容哈希：尺寸、格式与每行的像素字节（不含对齐填充），不会为0
+inline std::size_t imageContentHash(QImage const &image, std::size_t seed)
+{
+    auto combine = [&seed](std::size_t value) {
+        seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    };
+
+    combine(static_cast<std::size_t>(image.width()));
+    combine(static_cast<std::size_t>(image.height()));
+    combine(static_cast<std::size_t>(image.format()));
+
+    std::size_t const rowBytes = (static_cast<std::size_t>(image.width()) * image.depth() + 7) / 8;
+
+    for (int y = 0; y < image.height(); ++y) {
+        std::string_view const row(reinterpret_cast<char const *>(image.constScanLine(y)), rowBytes);
+        combine(std::hash<std::string_view>()(row));
+    }
+
+    return seed != 0 ? seed : 1;
+}
+
+/**
+ * @brief 以QImage（隐式共享）保存的图片数据
+ *
+ * 与PixmapData不同，QImage可以在任意线程中使用：数据传出后只读，
+ * 工作线程可以同时读取同一块像素缓冲区而无需复制。
+ * 修改图片前先复制一份QImage，写入时才会分离出新的缓冲区。
+ * 同一份数据的所有使用者共享一个按需构建的mip金字塔。
+ */
+class ImageData : public NodeData
+{
+public:
+    ImageData() {}
+    ImageData(QImage image)
+        : _image(std::move(image)) {}
+
+    //! hash为imageContentHash(image, ImageData::HashSeed)，由创建数据的工作线程事先算好
+    ImageData(QImage image, std::size_t hash)
+        : _image(std::move(image)),
+          _hash(hash) {}
+
+    //! 在调用线程中遍历像素算出哈希：在工作线程中创建的数据不必在GUI线程中再算
+    static std::shared_ptr<ImageData> hashed(QImage image)
+    {
+        std::size_t const hash = imageContentHash(image, HashSeed);
+        return std::make_shared<ImageData>(std::move(image), hash);
+    }
+
+    static constexpr std::size_t HashSeed = 2;
+
+    NodeDataType type() const override
+    {
+        return { "image", "I" };
+    }
+
+    QImage const &image() const { return _image; }
+
+    bool isNull() const { return _image.isNull(); }
+    int width() const { return _image.width(); }
+    int height() const { return _image.height(); }
+    QImage::Format format() const { return _image.format(); }
+
+    //! 每行的字节数（含对齐填充）
+    qsizetype stride() const { return _image.bytesPerLine(); }
+
+    //! 只读访问像素，不会分离共享的缓冲区
+    uchar const *constBits() const { return _image.constBits(); }
+    uchar const *constScanLine(int y) const { return _image.constScanLine(y); }
+
+    //! 第一次调用时构建金字塔（耗时，应在工作线程中调用），之后直接返回；线程安全
+    std::shared_ptr<ImagePyramid const> pyramid() const
+    {
+        std::call_once(_pyramidOnce, [this] {
+            _pyramid = std::make_shared<ImagePyramid const>(_image);
+        });
+
+        return _pyramid;
+    }
+
+    //! 没有事先算好时，第一次调用遍历所有像素，之后直接返回；线程安全
+    std::size_t hash() const override
+    {
+        std::call_once(_hashOnce, [this] {
+            if (_hash == 0)
+                _hash = imageContentHash(_image, HashSeed);
+        });
+
+        return _hash;
+    }
+
+    std::size_t byteSize() const override
+    {
+        return static_cast<std::size_t>(_image.sizeInBytes());
+    }
+
+private:
+    QImage _image;
+
+    mutable std::once_flag _pyramidOnce;
+    mutable std::shared_ptr<ImagePyramid const> _pyramid;
+
+    mutable std::once_flag _hashOnce;
+    mutable std::size_t _hash = 0;
+};
@@ -0,0 +1,239 @@
+#include "imagefiltermodel.h"
+#include "imagedata.h"
+#include "tiledimagedata.h"
+
+#include <algorithm>
+
+#include <QCoreApplication>
+#include <QMutex>
+#include <QPointer>
+#include <QThreadPool>
+
+#include "computetask.h"
+
+// Taken from the model on the GUI thread, used by value on the workers.
+struct ImageFilterModel::Parameters
+{
+    Kernel kernel;
+    int tileMargin = 0;
+    QSize tiledInputSize;
+};
+
+// Shared with the jobs, which may outlive the model.
+struct ImageFilterModel::State
+{
+    QMutex mutex;
+
+    Parameters parameters;
+    std::vector<std::shared_ptr<NodeData>> inputs;
+
+    // every computation takes a number, older results never replace newer ones
+    quint64 sequence = 0;
+    quint64 resultSequence = 0;
+    std::shared_ptr<NodeData> result;
+};
+
+//! 每块输出由输入上同一级别、加了边距的同一区域计算
+static std::shared_ptr<NodeData> tiledResult(ImageFilterModel::Kernel const &kernel,
+                                             int margin,
+                                             std::vector<std::shared_ptr<TiledImageData>> const &inputs)
+{
+    QSize const size = inputs[0]->size();
+
+    return std::make_shared<TiledImageData>(size, [kernel, margin, inputs](int level, QRect const &rect) {
+        // the margin shrinks with the level, as the kernel's extent does
+        int const levelMargin = (margin + (1 << level) - 1) >> level;
+
+        QRect const source = rect.adjusted(-levelMargin, -levelMargin, levelMargin, levelMargin)
+                & QRect(QPoint(), inputs[0]->levelSize(level));
+
+        std::vector<QImage> regions;
+        for (auto const &input : inputs)
+            regions.push_back(input->region(level, source));
+
+        return kernel(regions, level).copy(rect.translated(-source.topLeft()));
+    });
+}
+
+bool ImageFilterModel::compute(State &state,
+                               quint64 sequence,
+                               Parameters const &parameters,
+                               std::vector<std::shared_ptr<NodeData>> const &inputs)
+{
+    std::vector<std::shared_ptr<TiledImageData>> tiles;
+    std::vector<QSize> sizes;
+
+    for (auto const &input : inputs) {
+        auto tiledInput = std::dynamic_pointer_cast<TiledImageData>(input);
+
+        sizes.push_back(tiledInput ? tiledInput->size() : imageFromData(input).size());
+        tiles.push_back(std::move(tiledInput));
+    }
+
+    bool const tiled = std::any_of(tiles.begin(), tiles.end(), [](auto const &t) { return t != nullptr; });
+
+    // large images are worked on lazily too, so that a preview downstream
+    // only costs the tiles it asks for, at its own resolution
+    bool const large = std::any_of(sizes.begin(), sizes.end(), [](QSize const &size) {
+        return static_cast<qint64>(size.width()) * size.height() >= LazyPixels;
+    });
+
+    // tiles of inputs with different sizes don't line up, those are put together whole
+    bool const byTiles = parameters.tileMargin >= 0 && (tiled || large) &&
+            std::all_of(sizes.begin(), sizes.end(), [&](QSize const &size) { return size == sizes[0]; });
+
+    std::shared_ptr<NodeData> result;
+
+    if (byTiles) {
+        bool ready = true;
+
+        for (std::size_t i = 0; i < inputs.size(); ++i) {
+            if (!tiles[i]) {
+                auto imageData = std::dynamic_pointer_cast<ImageData>(inputs[i]);
+                if (imageData && !imageData->isNull())
+                    tiles[i] = TiledImageData::fromImageData(imageData);
+            }
+
+            ready = ready && tiles[i] && !sizes[i].isEmpty();
+        }
+
+        if (ready)
+            result = tiledResult(parameters.kernel, parameters.tileMargin, tiles);
+    } else {
+        std::vector<QImage> images;
+        bool ready = true;
+
+        for (auto const &input : inputs) {
+            QImage image = toKernelFormat(imageFromData(input, parameters.tiledInputSize));
+            ready = ready && !image.isNull();
+
+            images.push_back(std::move(image));
+        }
+
+        if (ready) {
+            QImage image = parameters.kernel(images, 0);
+            if (!image.isNull())
+                result = ImageData::hashed(std::move(image));
+        }
+    }
+
+    QMutexLocker locker(&state.mutex);
+
+    if (sequence <= state.resultSequence)
+        return false;
+
+    state.resultSequence = sequence;
+    state.result = std::move(result);
+
+    return true;
+}
+
+ImageFilterModel::ImageFilterModel(unsigned int nInputs)
+    : _nInputs(nInputs),
+      _state(std::make_shared<State>()),
+      _widget(new QWidget),
+      _form(new QFormLayout(_widget))
+{
+    _state->inputs.resize(nInputs);
+
+    _widget->setAttribute(Qt::WA_NoSystemBackground);
+}
+
+ImageFilterModel::~ImageFilterModel() = default;
+
+unsigned int ImageFilterModel::nPorts(PortType portType) const
+{
+    switch (portType) {
+    case PortType::In:
+        return _nInputs;
+
+    case PortType::Out:
+        return 1;
+
+    default:
+        return 0;
+    }
+}
+
+NodeDataType ImageFilterModel::dataType(PortType, PortIndex) const
+{
+    return ImageData().type();
+}
+
+void ImageFilterModel::setInData(std::shared_ptr<NodeData> nodeData, PortIndex port)
+{
+    quint64 sequence;
+    Parameters parameters;
+    std::vector<std::shared_ptr<NodeData>> inputs;
+
+    {
+        QMutexLocker locker(&_state->mutex);
+
+        _state->inputs[port] = std::move(nodeData);
+
+        sequence = ++_state->sequence;
+        parameters = _state->parameters;
+        inputs = _state->inputs;
+    }
+
+    if (compute(*_state, sequence, parameters, inputs))
+        emit dataUpdated(0);
+}
+
+std::shared_ptr<NodeData> ImageFilterModel::outData(PortIndex)
+{
+    QMutexLocker locker(&_state->mutex);
+    return _state->result;
+}
+
+QImage ImageFilterModel::toKernelFormat(QImage const &image)
+{
+    if (image.isNull() || image.format() == kernelFormat())
+        return image;
+
+    return image.convertToFormat(kernelFormat());
+}
+
+ConstImageView ImageFilterModel::constView(QImage const &image)
+{
+    return { image.constBits(), image.width(), image.height(), image.bytesPerLine() };
+}
+
+ImageView ImageFilterModel::view(QImage &image)
+{
+    return { image.bits(), image.width(), image.height(), image.bytesPerLine() };
+}
+
+void ImageFilterModel::parametersChanged()
+{
+    Parameters const parameters { kernel(), tileMargin(), tiledInputSize() };
+
+    quint64 sequence;
+    std::vector<std::shared_ptr<NodeData>> inputs;
+
+    {
+        QMutexLocker locker(&_state->mutex);
+
+        _state->parameters = parameters;
+
+        if (std::all_of(_state->inputs.begin(), _state->inputs.end(),
+                        [](std::shared_ptr<NodeData> const &input) { return !input; }))
+            return;
+
+        sequence = ++_state->sequence;
+        inputs = _state->inputs;
+    }
+
+    QPointer<ImageFilterModel> model(this);
+    auto state = _state;
+
+    QThreadPool::globalInstance()->start(new ComputeTask([model, state, sequence, parameters, inputs] {
+        if (!compute(*state, sequence, parameters, inputs))
+            return;
+
+        QMetaObject::invokeMethod(qApp, [model] {
+            if (model)
+                emit model->dataUpdated(0);
+        }, Qt::QueuedConnection);
+    }));
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <QFormLayout>
+#include <QImage>
+#include <QWidget>
+
+#include "nodedatamodel.h"
+#include "imagekernels.h"
+
+/**
+ * @brief 图片处理节点的基类：若干ImageData输入，一个ImageData输出
+ *
+ * 计算在线程池中进行（asyncCompute）：输入到达时由图派发，参数改变时由模型自己派发。
+ * 子类实现kernel()，返回按值捕获当前参数的计算函数，计算函数不得访问模型本身，
+ * 因此模型在计算期间被删除也是安全的。只有在所有输入都连接时才计算。
+ *
+ * 输入可以是ImageData或TiledImageData。有分块输入或输入不小于LazyPixels，
+ * 且可以逐块计算（tileMargin() >= 0）时，输出为分块图片：每块只在被请求时，
+ * 由输入上同一级别、对应（加上边距）的区域计算。下游只请求较粗一级的某个区域时，
+ * 上游也只按这一级的分辨率计算这个区域
+ */
+class ImageFilterModel : public NodeDataModel
+{
+    Q_OBJECT
+
+public:
+    //! 由输入计算输出，输入均已转换为kernelFormat()，在工作线程中执行。
+    //! level为输入所在的mip级别（0为原始分辨率），与尺寸相关的参数（如模糊半径）按2^level缩小
+    using Kernel = std::function<QImage(std::vector<QImage> const &inputs, int level)>;
+
+    //! 不小于此像素数的ImageData输入也逐块按需计算
+    static constexpr qint64 LazyPixels = 2048 * 2048;
+
+public:
+    explicit ImageFilterModel(unsigned int nInputs = 1);
+    ~ImageFilterModel() override;
+
+public:
+    unsigned int nPorts(PortType portType) const override;
+
+    NodeDataType dataType(PortType portType, PortIndex portIndex) const override;
+
+    void setInData(std::shared_ptr<NodeData> nodeData, PortIndex port) override;
+
+    std::shared_ptr<NodeData> outData(PortIndex port) override;
+
+    QWidget *embeddedWidget() override { return _widget; }
+
+    bool asyncCompute() const override { return true; }
+
+    //! 输出只取决于输入与save()保存的参数
+    bool memoizable() const override { return true; }
+
+public:
+    //! 处理核使用的像素格式
+    static constexpr QImage::Format kernelFormat() { return QImage::Format_ARGB32_Premultiplied; }
+
+    //! 转换为kernelFormat()，已是该格式时不复制
+    static QImage toKernelFormat(QImage const &image);
+
+    static ConstImageView constView(QImage const &image);
+    static ImageView view(QImage &image);
+
+protected:
+    //! 以当前参数创建计算函数（GUI线程）
+    virtual Kernel kernel() const = 0;
+
+    //! 逐块计算时每块输出需要的输入边距（第0级的像素），返回负值表示不能逐块计算（GUI线程）
+    virtual int tileMargin() const { return 0; }
+
+    //! 不能逐块计算时，分块输入拼成整张图片所用的最小尺寸，无效时使用原始分辨率（GUI线程）
+    virtual QSize tiledInputSize() const { return QSize(); }
+
+    //! 子类构造完成及参数改变后调用：更新计算函数，并在线程池中以当前输入重新计算
+    void parametersChanged();
+
+    //! 参数编辑部件所在的布局
+    QFormLayout *form() const { return _form; }
+
+private:
+    struct Parameters;
+    struct State;
+
+    //! 计算，结果未被更新的计算取代时保存并返回true
+    static bool compute(State &state,
+                        quint64 sequence,
+                        Parameters const &parameters,
+                        std::vector<std::shared_ptr<NodeData>> const &inputs);
+
+    unsigned int _nInputs;
+    std::shared_ptr<State> _state;
+
+    QWidget *_widget;
+    QFormLayout *_form;
+};
@@ -0,0 +1,374 @@
+#include "imagefilters.h"
+
+#include <array>
+#include <iterator>
+
+#include <QGridLayout>
+#include <QJsonArray>
+#include <QSignalBlocker>
+
+#include "parallelrows.h"
+
+//! 与input尺寸相同、kernelFormat()格式的输出图片
+static QImage imageLike(QImage const &input)
+{
+    return QImage(input.size(), ImageFilterModel::kernelFormat());
+}
+
+static QImage resized(QImage const &input, QSize const &size)
+{
+    if (input.size() == size)
+        return input;
+
+    QImage output(size, ImageFilterModel::kernelFormat());
+
+    ConstImageView const in = ImageFilterModel::constView(input);
+    ImageView const out = ImageFilterModel::view(output);
+
+    parallelRows(size.height(), [&](int rowBegin, int rowEnd) {
+        ImageKernels::best().resizeBilinear(in, out, rowBegin, rowEnd);
+    });
+
+    return output;
+}
+
+ImageBlurModel::ImageBlurModel()
+    : ImageFilterModel(1),
+      _radius(new QSpinBox)
+{
+    _radius->setRange(0, ImageKernels::MaxBlurRadius);
+    _radius->setValue(2);
+
+    form()->addRow(tr("Radius"), _radius);
+
+    connect(_radius, qOverload<int>(&QSpinBox::valueChanged), this, &ImageBlurModel::parametersChanged);
+
+    parametersChanged();
+}
+
+QJsonObject ImageBlurModel::save() const
+{
+    QJsonObject modelJson = NodeDataModel::save();
+    modelJson["radius"] = _radius->value();
+
+    return modelJson;
+}
+
+void ImageBlurModel::restore(QJsonObject const &modelJson)
+{
+    _radius->setValue(modelJson["radius"].toInt(_radius->value()));
+}
+
+ImageFilterModel::Kernel ImageBlurModel::kernel() const
+{
+    int const radius = _radius->value();
+
+    return [radius](std::vector<QImage> const &inputs, int level) {
+        // the radius in pixels of the level, rounded
+        int const levelRadius = (radius + (1 << level >> 1)) >> level;
+
+        QImage horizontal = imageLike(inputs[0]);
+        QImage output = imageLike(inputs[0]);
+
+        ConstImageView const in = constView(inputs[0]);
+        ImageView const temp = view(horizontal);
+        ImageView const out = view(output);
+
+        ImageKernels const &kernels = ImageKernels::best();
+
+        parallelRows(in.height, [&](int rowBegin, int rowEnd) {
+            kernels.boxBlurHorizontal(in, temp, levelRadius, rowBegin, rowEnd);
+        });
+
+        parallelRows(in.height, [&](int rowBegin, int rowEnd) {
+            kernels.boxBlurVertical(temp, out, levelRadius, rowBegin, rowEnd);
+        });
+
+        return output;
+    };
+}
+
+int ImageBlurModel::tileMargin() const
+{
+    return _radius->value();
+}
+
+ImageResizeModel::ImageResizeModel()
+    : ImageFilterModel(1),
+      _width(new QSpinBox),
+      _height(new QSpinBox)
+{
+    for (QSpinBox *spinBox : { _width, _height }) {
+        spinBox->setRange(1, 16384);
+        spinBox->setValue(256);
+
+        connect(spinBox, qOverload<int>(&QSpinBox::valueChanged), this, &ImageResizeModel::parametersChanged);
+    }
+
+    form()->addRow(tr("Width"), _width);
+    form()->addRow(tr("Height"), _height);
+
+    parametersChanged();
+}
+
+QJsonObject ImageResizeModel::save() const
+{
+    QJsonObject modelJson = NodeDataModel::save();
+    modelJson["width"] = _width->value();
+    modelJson["height"] = _height->value();
+
+    return modelJson;
+}
+
+void ImageResizeModel::restore(QJsonObject const &modelJson)
+{
+    _width->setValue(modelJson["width"].toInt(_width->value()));
+    _height->setValue(modelJson["height"].toInt(_height->value()));
+}
+
+ImageFilterModel::Kernel ImageResizeModel::kernel() const
+{
+    QSize const size(_width->value(), _height->value());
+
+    return [size](std::vector<QImage> const &inputs, int) {
+        return resized(inputs[0], size);
+    };
+}
+
+QSize ImageResizeModel::tiledInputSize() const
+{
+    return QSize(_width->value(), _height->value());
+}
+
+ImageGrayscaleModel::ImageGrayscaleModel()
+    : ImageFilterModel(1)
+{
+    parametersChanged();
+}
+
+ImageFilterModel::Kernel ImageGrayscaleModel::kernel() const
+{
+    return [](std::vector<QImage> const &inputs, int) {
+        QImage output = imageLike(inputs[0]);
+
+        ConstImageView const in = constView(inputs[0]);
+        ImageView const out = view(output);
+
+        parallelRows(in.height, [&](int rowBegin, int rowEnd) {
+            ImageKernels::best().grayscale(in, out, rowBegin, rowEnd);
+        });
+
+        return output;
+    };
+}
+
+ImageThresholdModel::ImageThresholdModel()
+    : ImageFilterModel(1),
+      _level(new QSpinBox)
+{
+    _level->setRange(0, 256);
+    _level->setValue(128);
+
+    form()->addRow(tr("Level"), _level);
+
+    connect(_level, qOverload<int>(&QSpinBox::valueChanged), this, &ImageThresholdModel::parametersChanged);
+
+    parametersChanged();
+}
+
+QJsonObject ImageThresholdModel::save() const
+{
+    QJsonObject modelJson = NodeDataModel::save();
+    modelJson["level"] = _level->value();
+
+    return modelJson;
+}
+
+void ImageThresholdModel::restore(QJsonObject const &modelJson)
+{
+    _level->setValue(modelJson["level"].toInt(_level->value()));
+}
+
+ImageFilterModel::Kernel ImageThresholdModel::kernel() const
+{
+    int const level = _level->value();
+
+    return [level](std::vector<QImage> const &inputs, int) {
+        QImage output = imageLike(inputs[0]);
+
+        ConstImageView const in = constView(inputs[0]);
+        ImageView const out = view(output);
+
+        parallelRows(in.height, [&](int rowBegin, int rowEnd) {
+            ImageKernels::best().threshold(in, out, level, rowBegin, rowEnd);
+        });
+
+        return output;
+    };
+}
+
+ImageBlendModel::ImageBlendModel()
+    : ImageFilterModel(2),
+      _weight(new QSpinBox)
+{
+    _weight->setRange(0, 100);
+    _weight->setValue(50);
+    _weight->setSuffix("%");
+
+    form()->addRow(tr("Second"), _weight);
+
+    connect(_weight, qOverload<int>(&QSpinBox::valueChanged), this, &ImageBlendModel::parametersChanged);
+
+    parametersChanged();
+}
+
+QJsonObject ImageBlendModel::save() const
+{
+    QJsonObject modelJson = NodeDataModel::save();
+    modelJson["weight"] = _weight->value();
+
+    return modelJson;
+}
+
+void ImageBlendModel::restore(QJsonObject const &modelJson)
+{
+    _weight->setValue(modelJson["weight"].toInt(_weight->value()));
+}
+
+ImageFilterModel::Kernel ImageBlendModel::kernel() const
+{
+    int const weight = (_weight->value() * 256 + 50) / 100;
+
+    return [weight](std::vector<QImage> const &inputs, int) {
+        QImage const second = resized(inputs[1], inputs[0].size());
+        QImage output = imageLike(inputs[0]);
+
+        ConstImageView const a = constView(inputs[0]);
+        ConstImageView const b = constView(second);
+        ImageView const out = view(output);
+
+        parallelRows(a.height, [&](int rowBegin, int rowEnd) {
+            ImageKernels::best().blend(a, b, out, weight, rowBegin, rowEnd);
+        });
+
+        return output;
+    };
+}
+
+namespace {
+
+struct ConvolutionPreset
+{
+    char const *name;
+    float coefficients[9];
+};
+
+ConvolutionPreset const convolutionPresets[] = {
+    { "Sharpen",  {  0, -1,  0, -1,  5, -1,  0, -1,  0 } },
+    { "Edges",    { -1, -1, -1, -1,  8, -1, -1, -1, -1 } },
+    { "Emboss",   { -2, -1,  0, -1,  1,  1,  0,  1,  2 } },
+    { "Smooth",   { 1 / 16.f, 2 / 16.f, 1 / 16.f, 2 / 16.f, 4 / 16.f, 2 / 16.f, 1 / 16.f, 2 / 16.f, 1 / 16.f } },
+    { "Identity", {  0,  0,  0,  0,  1,  0,  0,  0,  0 } },
+};
+
+} // namespace
+
+ImageConvolutionModel::ImageConvolutionModel()
+    : ImageFilterModel(1),
+      _preset(new QComboBox)
+{
+    for (auto const &preset : convolutionPresets)
+        _preset->addItem(tr(preset.name));
+    _preset->addItem(tr("Custom"));
+
+    auto grid = new QWidget;
+    auto gridLayout = new QGridLayout(grid);
+    gridLayout->setContentsMargins(0, 0, 0, 0);
+
+    for (int i = 0; i < 9; ++i) {
+        _coefficients[i] = new QDoubleSpinBox;
+        _coefficients[i]->setRange(-100.0, 100.0);
+        _coefficients[i]->setDecimals(3);
+        _coefficients[i]->setSingleStep(0.25);
+
+        gridLayout->addWidget(_coefficients[i], i / 3, i % 3);
+    }
+
+    form()->addRow(tr("Kernel"), _preset);
+    form()->addRow(grid);
+
+    applyPreset(0);
+
+    connect(_preset, qOverload<int>(&QComboBox::activated), this, &ImageConvolutionModel::applyPreset);
+
+    for (QDoubleSpinBox *coefficient : _coefficients) {
+        connect(coefficient, qOverload<double>(&QDoubleSpinBox::valueChanged), this, [this] {
+            _preset->setCurrentIndex(_preset->count() - 1);
+            parametersChanged();
+        });
+    }
+}
+
+void ImageConvolutionModel::applyPreset(int index)
+{
+    if (index < 0 || index >= static_cast<int>(std::size(convolutionPresets)))
+        return;
+
+    for (int i = 0; i < 9; ++i) {
+        QSignalBlocker blocker(_coefficients[i]);
+        _coefficients[i]->setValue(convolutionPresets[index].coefficients[i]);
+    }
+
+    _preset->setCurrentIndex(index);
+
+    parametersChanged();
+}
+
+QJsonObject ImageConvolutionModel::save() const
+{
+    QJsonObject modelJson = NodeDataModel::save();
+
+    QJsonArray coefficients;
+    for (QDoubleSpinBox const *coefficient : _coefficients)
+        coefficients.append(coefficient->value());
+
+    modelJson["kernel"] = coefficients;
+
+    return modelJson;
+}
+
+void ImageConvolutionModel::restore(QJsonObject const &modelJson)
+{
+    QJsonArray const coefficients = modelJson["kernel"].toArray();
+    if (coefficients.size() != 9)
+        return;
+
+    for (int i = 0; i < 9; ++i) {
+        QSignalBlocker blocker(_coefficients[i]);
+        _coefficients[i]->setValue(coefficients[i].toDouble());
+    }
+
+    _preset->setCurrentIndex(_preset->count() - 1);
+
+    parametersChanged();
+}
+
+ImageFilterModel::Kernel ImageConvolutionModel::kernel() const
+{
+    std::array<float, 9> coefficients;
+    for (int i = 0; i < 9; ++i)
+        coefficients[i] = static_cast<float>(_coefficients[i]->value());
+
+    return [coefficients](std::vector<QImage> const &inputs, int) {
+        QImage output = imageLike(inputs[0]);
+
+        ConstImageView const in = constView(inputs[0]);
+        ImageView const out = view(output);
+
+        parallelRows(in.height, [&](int rowBegin, int rowEnd) {
+            ImageKernels::best().convolve3x3(in, out, coefficients.data(), rowBegin, rowEnd);
+        });
+
+        return output;
+    };
+}
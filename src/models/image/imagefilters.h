@@ -0,0 +1,148 @@
+#pragma once
+
+#include <QComboBox>
+#include <QDoubleSpinBox>
+#include <QSpinBox>
+
+#include "imagefiltermodel.h"
+
+/**
+ * @brief 盒式模糊（先水平后垂直）
+ */
+class ImageBlurModel : public ImageFilterModel
+{
+    Q_OBJECT
+
+public:
+    ImageBlurModel();
+
+    QString caption() const override { return QString("Blur"); }
+    QString name() const override { return QString("ImageBlurModel"); }
+
+    QJsonObject save() const override;
+    void restore(QJsonObject const &modelJson) override;
+
+protected:
+    Kernel kernel() const override;
+    int tileMargin() const override;
+
+private:
+    QSpinBox *_radius;
+};
+
+/**
+ * @brief 双线性插值缩放
+ */
+class ImageResizeModel : public ImageFilterModel
+{
+    Q_OBJECT
+
+public:
+    ImageResizeModel();
+
+    QString caption() const override { return QString("Resize"); }
+    QString name() const override { return QString("ImageResizeModel"); }
+
+    QJsonObject save() const override;
+    void restore(QJsonObject const &modelJson) override;
+
+protected:
+    Kernel kernel() const override;
+    int tileMargin() const override { return -1; }
+    QSize tiledInputSize() const override;
+
+private:
+    QSpinBox *_width;
+    QSpinBox *_height;
+};
+
+/**
+ * @brief 颜色转换：彩色转为灰度
+ */
+class ImageGrayscaleModel : public ImageFilterModel
+{
+    Q_OBJECT
+
+public:
+    ImageGrayscaleModel();
+
+    QString caption() const override { return QString("Grayscale"); }
+    QString name() const override { return QString("ImageGrayscaleModel"); }
+
+protected:
+    Kernel kernel() const override;
+};
+
+/**
+ * @brief 按亮度二值化
+ */
+class ImageThresholdModel : public ImageFilterModel
+{
+    Q_OBJECT
+
+public:
+    ImageThresholdModel();
+
+    QString caption() const override { return QString("Threshold"); }
+    QString name() const override { return QString("ImageThresholdModel"); }
+
+    QJsonObject save() const override;
+    void restore(QJsonObject const &modelJson) override;
+
+protected:
+    Kernel kernel() const override;
+
+private:
+    QSpinBox *_level;
+};
+
+/**
+ * @brief 两张图片按权重混合，尺寸不同时第二张缩放到第一张的尺寸
+ */
+class ImageBlendModel : public ImageFilterModel
+{
+    Q_OBJECT
+
+public:
+    ImageBlendModel();
+
+    QString caption() const override { return QString("Blend"); }
+    QString name() const override { return QString("ImageBlendModel"); }
+
+    QJsonObject save() const override;
+    void restore(QJsonObject const &modelJson) override;
+
+protected:
+    Kernel kernel() const override;
+
+private:
+    QSpinBox *_weight;
+};
+
+/**
+ * @brief 3x3卷积
+ */
+class ImageConvolutionModel : public ImageFilterModel
+{
+    Q_OBJECT
+
+public:
+    ImageConvolutionModel();
+
+    QString caption() const override { return QString("Convolution"); }
+    QString name() const override { return QString("ImageConvolutionModel"); }
+
+    QJsonObject save() const override;
+    void restore(QJsonObject const &modelJson) override;
+
+protected:
+    Kernel kernel() const override;
+    int tileMargin() const override { return 1; }
+
+private:
+    void applyPreset(int index);
+
+private:
+    QComboBox *_preset;
+    QDoubleSpinBox *_coefficients[9];
+};
@@ -0,0 +1,142 @@
+#include "imageformats.h"
+
+#include <utility>
+#include <vector>
+
+#include "floatplanesdata.h"
+#include "imagekernels.h"
+#include "parallelrows.h"
+#include "tiledimagedata.h"
+
+NodeDataType imageFormatType(QImage::Format format)
+{
+    switch (format) {
+    case QImage::Format_Grayscale8:
+        return { "image_gray8", "Gray8" };
+
+    case QImage::Format_RGB888:
+        return { "image_rgb888", "RGB888" };
+
+    case QImage::Format_RGBA8888:
+        return { "image_rgba8888", "RGBA8888" };
+
+    default:
+        return ImageData().type();
+    }
+}
+
+//! 与通道数对应、字节交错排列的8位格式
+static QImage::Format byteFormat(int channels)
+{
+    switch (channels) {
+    case 1:
+        return QImage::Format_Grayscale8;
+    case 3:
+        return QImage::Format_RGB888;
+    default:
+        return QImage::Format_RGBA8888;
+    }
+}
+
+static std::shared_ptr<FloatPlanesData> imageToPlanes(QImage const &image)
+{
+    int const channels = image.format() == QImage::Format_Grayscale8 ? 1 : image.hasAlphaChannel() ? 4 : 3;
+
+    // Qt's own conversions, a no-op when the layout already matches
+    QImage const bytes = image.convertToFormat(byteFormat(channels));
+
+    auto planes = std::make_shared<FloatPlanesData>(bytes.width(), bytes.height(), channels);
+
+    std::size_t const planeSize = static_cast<std::size_t>(bytes.width()) * bytes.height();
+    float *values = planes->plane(0);
+
+    parallelRows(bytes.height(), [&](int rowBegin, int rowEnd) {
+        ImageKernels const &kernels = ImageKernels::best();
+
+        for (int y = rowBegin; y < rowEnd; ++y) {
+            float *rows[4];
+            for (int c = 0; c < channels; ++c)
+                rows[c] = values + c * planeSize + static_cast<std::size_t>(y) * bytes.width();
+
+            kernels.unpackToFloat(bytes.constScanLine(y), channels, rows, bytes.width());
+        }
+    });
+
+    return planes;
+}
+
+static QImage planesToImage(FloatPlanesData const &planes)
+{
+    QImage image(planes.width(), planes.height(), byteFormat(planes.channels()));
+
+    int const channels = planes.channels();
+    std::size_t const planeSize = static_cast<std::size_t>(planes.width()) * planes.height();
+    float const *values = planes.plane(0);
+
+    parallelRows(image.height(), [&](int rowBegin, int rowEnd) {
+        ImageKernels const &kernels = ImageKernels::best();
+
+        for (int y = rowBegin; y < rowEnd; ++y) {
+            float const *rows[4];
+            for (int c = 0; c < channels; ++c)
+                rows[c] = values + c * planeSize + static_cast<std::size_t>(y) * planes.width();
+
+            kernels.packFromFloat(rows, channels, image.scanLine(y), planes.width());
+        }
+    });
+
+    return image;
+}
+
+//! 任意图片数据中的图片，浮点平面按通道数打包为8位格式
+static QImage imageOf(SharedNodeData const &data)
+{
+    if (auto planes = std::dynamic_pointer_cast<FloatPlanesData>(data))
+        return planes->isNull() ? QImage() : planesToImage(*planes);
+
+    return imageFromData(data);
+}
+
+static SharedNodeData toImage(SharedNodeData data)
+{
+    // every formatted image already is an ImageData
+    if (std::dynamic_pointer_cast<ImageData>(data))
+        return data;
+
+    QImage const image = imageOf(data);
+
+    return image.isNull() ? nullptr : std::make_shared<ImageData>(image);
+}
+
+template <QImage::Format F>
+static SharedNodeData toFormat(SharedNodeData data)
+{
+    QImage const image = imageOf(data);
+
+    return image.isNull() ? nullptr : std::make_shared<FormatImageData<F>>(image);
+}
+
+static SharedNodeData toPlanes(SharedNodeData data)
+{
+    QImage const image = imageFromData(data);
+
+    return image.isNull() ? nullptr : imageToPlanes(image);
+}
+
+void registerImageFormatConverters(DataModelRegistry &registry)
+{
+    std::vector<std::pair<NodeDataType, TypeConverter>> const targets = {
+        { ImageData().type(), toImage },
+        { Gray8ImageData().type(), toFormat<QImage::Format_Grayscale8> },
+        { Rgb888ImageData().type(), toFormat<QImage::Format_RGB888> },
+        { Rgba8888ImageData().type(), toFormat<QImage::Format_RGBA8888> },
+        { FloatPlanesData().type(), toPlanes },
+    };
+
+    for (auto const &from : targets) {
+        for (auto const &to : targets) {
+            if (!(from.first == to.first))
+                registry.registerTypeConverter({ from.first, to.first }, to.second);
+        }
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <QImage>
+
+#include "datamodelregistry.h"
+#include "imagedata.h"
+
+//! 指定像素格式的图片数据类型
+NodeDataType imageFormatType(QImage::Format format);
+
+/**
+ * @brief 保证为某一像素格式的ImageData
+ *
+ * 端口声明为这些类型时，连接上自动转换其他图片数据（见registerImageFormatConverters）。
+ * 仍是ImageData，只接受ImageData的代码照常可用
+ */
+template <QImage::Format F>
+class FormatImageData : public ImageData
+{
+public:
+    static constexpr QImage::Format Format = F;
+
+    FormatImageData() {}
+
+    //! image已是该格式时共享其缓冲区，不复制
+    explicit FormatImageData(QImage const &image)
+        : ImageData(image.isNull() || image.format() == F ? image : image.convertToFormat(F))
+    {}
+
+    NodeDataType type() const override
+    {
+        return imageFormatType(F);
+    }
+};
+
+using Gray8ImageData    = FormatImageData<QImage::Format_Grayscale8>;
+using Rgb888ImageData   = FormatImageData<QImage::Format_RGB888>;
+using Rgba8888ImageData = FormatImageData<QImage::Format_RGBA8888>;
+
+/**
+ * @brief 注册ImageData、Gray8、RGB888、RGBA8888与FloatPlanesData两两之间的转换
+ *
+ * 布局相同时直接共享缓冲区（如Gray8转ImageData返回同一份数据）；
+ * 8位格式之间由QImage转换，与浮点平面之间用ImageKernels的向量化实现按行并行转换
+ */
+void registerImageFormatConverters(DataModelRegistry &registry);
@@ -0,0 +1,108 @@
+#include "imagegammamodel.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <QFormLayout>
+
+#include "parallelrows.h"
+
+ImageGammaModel::ImageGammaModel()
+    : _widget(new QWidget),
+      _gamma(new QDoubleSpinBox)
+{
+    _widget->setAttribute(Qt::WA_NoSystemBackground);
+
+    _gamma->setRange(0.1, 10.0);
+    _gamma->setSingleStep(0.1);
+    _gamma->setValue(2.2);
+
+    auto form = new QFormLayout(_widget);
+    form->addRow(tr("Gamma"), _gamma);
+
+    connect(_gamma, qOverload<double>(&QDoubleSpinBox::valueChanged), this, &ImageGammaModel::compute);
+}
+
+QJsonObject ImageGammaModel::save() const
+{
+    QJsonObject modelJson = NodeDataModel::save();
+    modelJson["gamma"] = _gamma->value();
+
+    return modelJson;
+}
+
+void ImageGammaModel::restore(QJsonObject const &modelJson)
+{
+    _gamma->setValue(modelJson["gamma"].toDouble(_gamma->value()));
+}
+
+unsigned int ImageGammaModel::nPorts(PortType portType) const
+{
+    switch (portType) {
+    case PortType::In:
+    case PortType::Out:
+        return 1;
+
+    default:
+        return 0;
+    }
+}
+
+NodeDataType ImageGammaModel::dataType(PortType, PortIndex) const
+{
+    return FloatPlanesData().type();
+}
+
+void ImageGammaModel::setInData(std::shared_ptr<NodeData> nodeData, PortIndex)
+{
+    _input = std::dynamic_pointer_cast<FloatPlanesData>(nodeData);
+
+    compute();
+}
+
+std::shared_ptr<NodeData> ImageGammaModel::outData(PortIndex)
+{
+    return _output;
+}
+
+void ImageGammaModel::compute()
+{
+    if (!_input || _input->isNull()) {
+        _output.reset();
+        emit dataUpdated(0);
+        return;
+    }
+
+    int const width = _input->width();
+    int const height = _input->height();
+    int const channels = _input->channels();
+
+    // the alpha plane comes last and is copied as is
+    int const colourChannels = channels == 4 ? 3 : channels;
+    float const exponent = static_cast<float>(1.0 / _gamma->value());
+
+    auto output = std::make_shared<FloatPlanesData>(width, height, channels);
+    auto input = _input;
+
+    parallelRows(height, [&](int rowBegin, int rowEnd) {
+        std::size_t const begin = static_cast<std::size_t>(rowBegin) * width;
+        std::size_t const end = static_cast<std::size_t>(rowEnd) * width;
+
+        for (int c = 0; c < channels; ++c) {
+            float const *in = input->plane(c);
+            float *out = output->plane(c);
+
+            if (c >= colourChannels) {
+                std::copy(in + begin, in + end, out + begin);
+                continue;
+            }
+
+            for (std::size_t i = begin; i < end; ++i)
+                out[i] = in[i] > 0.0f ? std::pow(in[i], exponent) : in[i];
+        }
+    });
+
+    _output = std::move(output);
+
+    emit dataUpdated(0);
+}
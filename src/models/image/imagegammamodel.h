@@ -0,0 +1,56 @@
+#pragma once
+
+#include <memory>
+
+#include <QDoubleSpinBox>
+#include <QWidget>
+
+#include "nodedatamodel.h"
+#include "floatplanesdata.h"
+
+/**
+ * @brief 浮点平面上的gamma校正
+ *
+ * 输入与输出端口都是FloatPlanesData：接到图片输出上时，连接按行把像素展开为浮点平面，
+ * 接到图片输入上时再打包为8位格式（见registerImageFormatConverters）。
+ * 颜色通道取value^(1/gamma)，alpha不变。在浮点上计算，多级串联也不会产生色带
+ */
+class ImageGammaModel : public NodeDataModel
+{
+    Q_OBJECT
+
+public:
+    ImageGammaModel();
+
+public:
+    QString caption() const override { return QString("Gamma"); }
+    QString name() const override { return QString("ImageGammaModel"); }
+
+    QJsonObject save() const override;
+    void restore(QJsonObject const &modelJson) override;
+
+public:
+    unsigned int nPorts(PortType portType) const override;
+
+    NodeDataType dataType(PortType portType, PortIndex portIndex) const override;
+
+    void setInData(std::shared_ptr<NodeData> nodeData, PortIndex port) override;
+
+    std::shared_ptr<NodeData> outData(PortIndex port) override;
+
+    QWidget *embeddedWidget() override { return _widget; }
+
+    //! 输出只取决于输入与save()保存的参数
+    bool memoizable() const override { return true; }
+
+private:
+    //! 以当前的gamma由输入计算输出并发出dataUpdated
+    void compute();
+
+private:
+    QWidget *_widget;
+    QDoubleSpinBox *_gamma;
+
+    std::shared_ptr<FloatPlanesData> _input;
+    std::shared_ptr<FloatPlanesData> _output;
+};
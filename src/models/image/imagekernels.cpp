@@ -0,0 +1,295 @@
+#include "imagekernels.h"
+#include "imagekernels_p.h"
+
+#include <cmath>
+#include <vector>
+
+#if defined(IMAGE_KERNELS_SIMD) && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace imagekernels {
+
+void blendRow(std::uint32_t const *a, std::uint32_t const *b, std::uint32_t *out, int count, int weight)
+{
+    for (int x = 0; x < count; ++x)
+        out[x] = lerp(a[x], b[x], weight);
+}
+
+void grayscaleRow(std::uint32_t const *in, std::uint32_t *out, int count)
+{
+    for (int x = 0; x < count; ++x) {
+        std::uint32_t const l = static_cast<std::uint32_t>(luminance(in[x]));
+        out[x] = (in[x] & 0xff000000) | l * 0x010101;
+    }
+}
+
+void thresholdRow(std::uint32_t const *in, std::uint32_t *out, int count, int level)
+{
+    for (int x = 0; x < count; ++x)
+        out[x] = luminance(in[x]) >= level ? 0xffffffff : 0xff000000;
+}
+
+std::uint32_t convolvePixel(ConstImageView in, int x, int y, float const *kernel)
+{
+    float acc[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+    for (int ky = 0; ky < 3; ++ky) {
+        std::uint32_t const *row = in.row(clampIndex(y + ky - 1, in.height));
+
+        for (int kx = 0; kx < 3; ++kx) {
+            std::uint32_t const p = row[clampIndex(x + kx - 1, in.width)];
+            float const k = kernel[ky * 3 + kx];
+
+            for (int c = 0; c < 4; ++c)
+                acc[c] = acc[c] + k * static_cast<float>(p >> (8 * c) & 0xff);
+        }
+    }
+
+    int channels[4];
+    for (int c = 0; c < 4; ++c)
+        channels[c] = std::min(std::max(static_cast<int>(std::lrint(acc[c])), 0), 255);
+
+    // keep the colour premultiplied
+    for (int c = 0; c < 3; ++c)
+        channels[c] = std::min(channels[c], channels[3]);
+
+    return static_cast<std::uint32_t>(channels[0] | channels[1] << 8 | channels[2] << 16 | channels[3] << 24);
+}
+
+void resizeRowHorizontal(std::uint32_t const *in, int inWidth, std::uint32_t *out, int outWidth)
+{
+    for (int x = 0; x < outWidth; ++x) {
+        BilinearSample const s = bilinearSample(x, outWidth, inWidth);
+        out[x] = lerp(in[s.index], in[std::min(s.index + 1, inWidth - 1)], s.weight);
+    }
+}
+
+void unpackRow(std::uint8_t const *in, int channels, float *const *planes, int count)
+{
+    for (int x = 0; x < count; ++x) {
+        for (int c = 0; c < channels; ++c)
+            planes[c][x] = static_cast<float>(in[x * channels + c]) * ByteToFloat;
+    }
+}
+
+void packRow(float const *const *planes, int channels, std::uint8_t *out, int count)
+{
+    for (int x = 0; x < count; ++x) {
+        for (int c = 0; c < channels; ++c)
+            out[x * channels + c] = floatToByte(planes[c][x]);
+    }
+}
+
+} // namespace imagekernels
+
+using namespace imagekernels;
+
+static void blendScalar(ConstImageView a, ConstImageView b, ImageView out,
+                        int weight, int rowBegin, int rowEnd)
+{
+    for (int y = rowBegin; y < rowEnd; ++y)
+        blendRow(a.row(y), b.row(y), out.row(y), out.width, weight);
+}
+
+static void grayscaleScalar(ConstImageView in, ImageView out, int rowBegin, int rowEnd)
+{
+    for (int y = rowBegin; y < rowEnd; ++y)
+        grayscaleRow(in.row(y), out.row(y), out.width);
+}
+
+static void thresholdScalar(ConstImageView in, ImageView out, int level, int rowBegin, int rowEnd)
+{
+    for (int y = rowBegin; y < rowEnd; ++y)
+        thresholdRow(in.row(y), out.row(y), out.width, level);
+}
+
+static void boxBlurHorizontalScalar(ConstImageView in, ImageView out, int radius, int rowBegin, int rowEnd)
+{
+    std::uint32_t const multiplier = blurMultiplier(radius);
+    int const width = in.width;
+
+    for (int y = rowBegin; y < rowEnd; ++y) {
+        std::uint32_t const *src = in.row(y);
+        std::uint32_t *dst = out.row(y);
+
+        std::uint32_t sum[4] = { 0, 0, 0, 0 };
+
+        for (int i = -radius; i <= radius; ++i) {
+            std::uint32_t const p = src[clampIndex(i, width)];
+            for (int c = 0; c < 4; ++c)
+                sum[c] += p >> (8 * c) & 0xff;
+        }
+
+        for (int x = 0; x < width; ++x) {
+            std::uint32_t pixel = 0;
+            for (int c = 0; c < 4; ++c)
+                pixel |= blurDivide(sum[c], multiplier) << (8 * c);
+
+            dst[x] = pixel;
+
+            std::uint32_t const entering = src[clampIndex(x + radius + 1, width)];
+            std::uint32_t const leaving  = src[clampIndex(x - radius, width)];
+
+            for (int c = 0; c < 4; ++c)
+                sum[c] += (entering >> (8 * c) & 0xff) - (leaving >> (8 * c) & 0xff);
+        }
+    }
+}
+
+static void boxBlurVerticalScalar(ConstImageView in, ImageView out, int radius, int rowBegin, int rowEnd)
+{
+    std::uint32_t const multiplier = blurMultiplier(radius);
+    int const width = in.width;
+
+    // one running sum per channel of every column
+    std::vector<std::uint32_t> sums(static_cast<std::size_t>(width) * 4, 0);
+
+    for (int i = -radius; i <= radius; ++i) {
+        std::uint8_t const *src = reinterpret_cast<std::uint8_t const *>(in.row(clampIndex(rowBegin + i, in.height)));
+        for (int x = 0; x < width * 4; ++x)
+            sums[x] += src[x];
+    }
+
+    for (int y = rowBegin; y < rowEnd; ++y) {
+        std::uint8_t *dst = reinterpret_cast<std::uint8_t *>(out.row(y));
+        for (int x = 0; x < width * 4; ++x)
+            dst[x] = static_cast<std::uint8_t>(blurDivide(sums[x], multiplier));
+
+        std::uint8_t const *entering = reinterpret_cast<std::uint8_t const *>(in.row(clampIndex(y + radius + 1, in.height)));
+        std::uint8_t const *leaving  = reinterpret_cast<std::uint8_t const *>(in.row(clampIndex(y - radius, in.height)));
+
+        for (int x = 0; x < width * 4; ++x)
+            sums[x] += entering[x] - leaving[x];
+    }
+}
+
+static void resizeBilinearScalar(ConstImageView in, ImageView out, int rowBegin, int rowEnd)
+{
+    std::vector<std::uint32_t> interpolated(static_cast<std::size_t>(in.width));
+
+    for (int y = rowBegin; y < rowEnd; ++y) {
+        BilinearSample const s = bilinearSample(y, out.height, in.height);
+
+        blendRow(in.row(s.index), in.row(std::min(s.index + 1, in.height - 1)),
+                 interpolated.data(), in.width, s.weight);
+
+        resizeRowHorizontal(interpolated.data(), in.width, out.row(y), out.width);
+    }
+}
+
+static void convolve3x3Scalar(ConstImageView in, ImageView out, float const *kernel, int rowBegin, int rowEnd)
+{
+    for (int y = rowBegin; y < rowEnd; ++y) {
+        std::uint32_t *dst = out.row(y);
+        for (int x = 0; x < out.width; ++x)
+            dst[x] = convolvePixel(in, x, y, kernel);
+    }
+}
+
+ImageKernels const &ImageKernels::scalar()
+{
+    static ImageKernels const kernels = {
+        "scalar",
+        blendScalar,
+        grayscaleScalar,
+        thresholdScalar,
+        boxBlurHorizontalScalar,
+        boxBlurVerticalScalar,
+        resizeBilinearScalar,
+        convolve3x3Scalar,
+        unpackRow,
+        packRow,
+    };
+
+    return kernels;
+}
+
+#if defined(IMAGE_KERNELS_SIMD)
+
+enum class CpuLevel
+{
+    Scalar,
+    Sse41,
+    Avx2,
+};
+
+static CpuLevel detectCpuLevel()
+{
+#if defined(__GNUC__)
+    __builtin_cpu_init();
+
+    // also checks that the OS saves the AVX registers
+    if (__builtin_cpu_supports("avx2"))
+        return CpuLevel::Avx2;
+
+    if (__builtin_cpu_supports("sse4.1"))
+        return CpuLevel::Sse41;
+#elif defined(_MSC_VER)
+    int info[4];
+
+    __cpuid(info, 0);
+    int const maxLeaf = info[0];
+
+    __cpuid(info, 1);
+    bool const sse41   = (info[2] & (1 << 19)) != 0;
+    bool const osxsave = (info[2] & (1 << 27)) != 0;
+    bool const avx     = (info[2] & (1 << 28)) != 0;
+
+    if (avx && osxsave && maxLeaf >= 7 && (_xgetbv(0) & 0x6) == 0x6) {
+        __cpuidex(info, 7, 0);
+        if (info[1] & (1 << 5))
+            return CpuLevel::Avx2;
+    }
+
+    if (sse41)
+        return CpuLevel::Sse41;
+#endif
+
+    return CpuLevel::Scalar;
+}
+
+//! Kernels left null by a table are taken from the one below it.
+static void overrideKernels(ImageKernels &kernels, ImageKernels const &with)
+{
+    kernels.name = with.name;
+
+    if (with.blend)             kernels.blend = with.blend;
+    if (with.grayscale)         kernels.grayscale = with.grayscale;
+    if (with.threshold)         kernels.threshold = with.threshold;
+    if (with.boxBlurHorizontal) kernels.boxBlurHorizontal = with.boxBlurHorizontal;
+    if (with.boxBlurVertical)   kernels.boxBlurVertical = with.boxBlurVertical;
+    if (with.resizeBilinear)    kernels.resizeBilinear = with.resizeBilinear;
+    if (with.convolve3x3)       kernels.convolve3x3 = with.convolve3x3;
+    if (with.unpackToFloat)     kernels.unpackToFloat = with.unpackToFloat;
+    if (with.packFromFloat)     kernels.packFromFloat = with.packFromFloat;
+}
+
+ImageKernels const &ImageKernels::best()
+{
+    static ImageKernels const kernels = [] {
+        ImageKernels result = scalar();
+
+        CpuLevel const level = detectCpuLevel();
+
+        if (level >= CpuLevel::Sse41)
+            overrideKernels(result, *sse41Kernels());
+
+        if (level >= CpuLevel::Avx2)
+            overrideKernels(result, *avx2Kernels());
+
+        return result;
+    }();
+
+    return kernels;
+}
+
+#else
+
+ImageKernels const &ImageKernels::best()
+{
+    return scalar();
+}
+
+#endif
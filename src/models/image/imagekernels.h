@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief 只读的32位像素图像（0xAARRGGBB，预乘alpha，即QImage::Format_ARGB32_Premultiplied）
+ */
+struct ConstImageView
+{
+    std::uint8_t const *data;
+    int width;
+    int height;
+    std::ptrdiff_t stride;    //!< 每行字节数（含对齐填充）
+
+    std::uint32_t const *row(int y) const
+    {
+        return reinterpret_cast<std::uint32_t const *>(data + y * stride);
+    }
+};
+
+/**
+ * @brief 可写的32位像素图像
+ */
+struct ImageView
+{
+    std::uint8_t *data;
+    int width;
+    int height;
+    std::ptrdiff_t stride;
+
+    std::uint32_t *row(int y) const
+    {
+        return reinterpret_cast<std::uint32_t *>(data + y * stride);
+    }
+
+    operator ConstImageView() const { return { data, width, height, stride }; }
+};
+
+/**
+ * @brief 图像处理核
+ *
+ * 每个核只写出[rowBegin, rowEnd)范围内的输出行，便于按行分块多线程执行。
+ * 运行时根据CPU选择AVX2、SSE4.1或标量实现，各实现的结果逐字节相同。
+ * 除resizeBilinear外，输入与输出尺寸相同，且不能是同一块缓冲区。
+ * 最后两个是像素格式转换，按行调用
+ */
+struct ImageKernels
+{
+    //! 盒式模糊的最大半径
+    static constexpr int MaxBlurRadius = 64;
+
+    char const *name;
+
+    //! out = a + (b - a) * weight / 256，weight取值[0, 256]
+    void (*blend)(ConstImageView a, ConstImageView b, ImageView out,
+                  int weight, int rowBegin, int rowEnd);
+
+    //! 亮度（R*77 + G*150 + B*29）/ 256作为灰度，保留alpha
+    void (*grayscale)(ConstImageView in, ImageView out, int rowBegin, int rowEnd);
+
+    //! 亮度不小于level的像素为白色，否则为黑色（不透明）
+    void (*threshold)(ConstImageView in, ImageView out, int level, int rowBegin, int rowEnd);
+
+    //! 半径为radius的水平/垂直盒式模糊，边缘像素重复，radius取值[0, MaxBlurRadius]
+    void (*boxBlurHorizontal)(ConstImageView in, ImageView out, int radius, int rowBegin, int rowEnd);
+    void (*boxBlurVertical)(ConstImageView in, ImageView out, int radius, int rowBegin, int rowEnd);
+
+    //! 双线性插值缩放到out的尺寸（像素中心对齐）
+    void (*resizeBilinear)(ConstImageView in, ImageView out, int rowBegin, int rowEnd);
+
+    //! 3x3卷积（按行排列的9个系数），边缘像素重复，结果取整并截断到[0, alpha]
+    void (*convolve3x3)(ConstImageView in, ImageView out, float const *kernel, int rowBegin, int rowEnd);
+
+    //! 一行count个像素：交错排列的8位通道（channels为1、3或4）拆分为各通道的浮点平面，值为byte / 255
+    void (*unpackToFloat)(std::uint8_t const *in, int channels, float *const *planes, int count);
+
+    //! unpackToFloat的逆过程：乘255后就近取偶，截断到[0, 255]，NaN视为0
+    void (*packFromFloat)(float const *const *planes, int channels, std::uint8_t *out, int count);
+
+public:
+    //! 当前CPU可用的最快实现
+    static ImageKernels const &best();
+
+    //! 标量实现，在所有平台上可用
+    static ImageKernels const &scalar();
+};
@@ -0,0 +1,272 @@
+#include "imagekernels.h"
+#include "imagekernels_p.h"
+
+#include <vector>
+
+#include <immintrin.h>
+
+// Only the functions marked with IMAGE_KERNELS_TARGET use AVX2, they are
+// called when the CPU supports it. Kernels
+// which don't gain from the wider registers are left to the SSE4.1 table.
+
+using namespace imagekernels;
+
+namespace {
+
+IMAGE_KERNELS_TARGET("avx2")
+inline __m256i lumaWeights()
+{
+    return _mm256_setr_epi16(LumaB, LumaG, LumaR, 0, LumaB, LumaG, LumaR, 0,
+                             LumaB, LumaG, LumaR, 0, LumaB, LumaG, LumaR, 0);
+}
+
+//! luminance of 8 pixels, one per 32 bit lane, in pixel order
+IMAGE_KERNELS_TARGET("avx2")
+inline __m256i luminance8(__m256i pixels, __m256i weights)
+{
+    __m256i const zero = _mm256_setzero_si256();
+
+    // unpack and hadd both work within 128 bit lanes, which keeps the order
+    __m256i const lo = _mm256_madd_epi16(_mm256_unpacklo_epi8(pixels, zero), weights);
+    __m256i const hi = _mm256_madd_epi16(_mm256_unpackhi_epi8(pixels, zero), weights);
+
+    return _mm256_srli_epi32(_mm256_hadd_epi32(lo, hi), 8);
+}
+
+IMAGE_KERNELS_TARGET("avx2")
+inline void blendRowAvx2(std::uint32_t const *a, std::uint32_t const *b, std::uint32_t *out, int count, int weight)
+{
+    __m256i const zero = _mm256_setzero_si256();
+    __m256i const w    = _mm256_set1_epi16(static_cast<short>(weight));
+    __m256i const iw   = _mm256_set1_epi16(static_cast<short>(256 - weight));
+    __m256i const half = _mm256_set1_epi16(128);
+
+    int x = 0;
+    for (; x + 8 <= count; x += 8) {
+        __m256i const pa = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(a + x));
+        __m256i const pb = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(b + x));
+
+        __m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(pa, zero), iw),
+                                      _mm256_mullo_epi16(_mm256_unpacklo_epi8(pb, zero), w));
+        __m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(pa, zero), iw),
+                                      _mm256_mullo_epi16(_mm256_unpackhi_epi8(pb, zero), w));
+
+        lo = _mm256_srli_epi16(_mm256_add_epi16(lo, half), 8);
+        hi = _mm256_srli_epi16(_mm256_add_epi16(hi, half), 8);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + x), _mm256_packus_epi16(lo, hi));
+    }
+
+    blendRow(a + x, b + x, out + x, count - x, weight);
+}
+
+IMAGE_KERNELS_TARGET("avx2")
+void blend(ConstImageView a, ConstImageView b, ImageView out, int weight, int rowBegin, int rowEnd)
+{
+    for (int y = rowBegin; y < rowEnd; ++y)
+        blendRowAvx2(a.row(y), b.row(y), out.row(y), out.width, weight);
+}
+
+IMAGE_KERNELS_TARGET("avx2")
+void grayscale(ConstImageView in, ImageView out, int rowBegin, int rowEnd)
+{
+    __m256i const weights   = lumaWeights();
+    __m256i const alphaMask = _mm256_set1_epi32(static_cast<int>(0xff000000));
+    __m256i const replicate = _mm256_set1_epi32(0x010101);
+
+    for (int y = rowBegin; y < rowEnd; ++y) {
+        std::uint32_t const *src = in.row(y);
+        std::uint32_t *dst = out.row(y);
+
+        int x = 0;
+        for (; x + 8 <= out.width; x += 8) {
+            __m256i const pixels = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(src + x));
+            __m256i const gray   = _mm256_mullo_epi32(luminance8(pixels, weights), replicate);
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + x),
+                                _mm256_or_si256(gray, _mm256_and_si256(pixels, alphaMask)));
+        }
+
+        grayscaleRow(src + x, dst + x, out.width - x);
+    }
+}
+
+IMAGE_KERNELS_TARGET("avx2")
+void threshold(ConstImageView in, ImageView out, int level, int rowBegin, int rowEnd)
+{
+    __m256i const weights = lumaWeights();
+    __m256i const limit   = _mm256_set1_epi32(level - 1);
+    __m256i const black   = _mm256_set1_epi32(static_cast<int>(0xff000000));
+
+    for (int y = rowBegin; y < rowEnd; ++y) {
+        std::uint32_t const *src = in.row(y);
+        std::uint32_t *dst = out.row(y);
+
+        int x = 0;
+        for (; x + 8 <= out.width; x += 8) {
+            __m256i const pixels = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(src + x));
+            __m256i const above  = _mm256_cmpgt_epi32(luminance8(pixels, weights), limit);
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + x), _mm256_or_si256(above, black));
+        }
+
+        thresholdRow(src + x, dst + x, out.width - x, level);
+    }
+}
+
+//! (sum * multiplier + 32768) >> 16 on 32 bit lanes
+IMAGE_KERNELS_TARGET("avx2")
+inline __m256i blurDivide8(__m256i sum, __m256i multiplier)
+{
+    return _mm256_srli_epi32(_mm256_add_epi32(_mm256_mullo_epi32(sum, multiplier), _mm256_set1_epi32(32768)), 16);
+}
+
+//! s += add - subtract on every channel, 16 channels at a time
+IMAGE_KERNELS_TARGET("avx2")
+void accumulateRow(std::uint32_t *s, int bytes, std::uint8_t const *add, std::uint8_t const *subtract)
+{
+    int x = 0;
+    for (; x + 16 <= bytes; x += 16) {
+        __m256i a = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<__m128i const *>(add + x)));
+
+        if (subtract)
+            a = _mm256_sub_epi16(a, _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<__m128i const *>(subtract + x))));
+
+        __m256i const d0 = _mm256_cvtepi16_epi32(_mm256_castsi256_si128(a));
+        __m256i const d1 = _mm256_cvtepi16_epi32(_mm256_extracti128_si256(a, 1));
+
+        __m256i *sum0 = reinterpret_cast<__m256i *>(s + x);
+        __m256i *sum1 = reinterpret_cast<__m256i *>(s + x + 8);
+
+        _mm256_storeu_si256(sum0, _mm256_add_epi32(_mm256_loadu_si256(sum0), d0));
+        _mm256_storeu_si256(sum1, _mm256_add_epi32(_mm256_loadu_si256(sum1), d1));
+    }
+
+    for (; x < bytes; ++x)
+        s[x] += add[x] - (subtract ? subtract[x] : 0);
+}
+
+IMAGE_KERNELS_TARGET("avx2")
+void boxBlurVertical(ConstImageView in, ImageView out, int radius, int rowBegin, int rowEnd)
+{
+    std::uint32_t const multiplier = blurMultiplier(radius);
+    __m256i const multiplier8 = _mm256_set1_epi32(static_cast<int>(multiplier));
+    int const bytes = in.width * 4;
+
+    std::vector<std::uint32_t> sums(static_cast<std::size_t>(bytes), 0);
+    std::uint32_t *s = sums.data();
+
+    for (int i = -radius; i <= radius; ++i)
+        accumulateRow(s, bytes, reinterpret_cast<std::uint8_t const *>(in.row(clampIndex(rowBegin + i, in.height))), nullptr);
+
+    for (int y = rowBegin; y < rowEnd; ++y) {
+        std::uint8_t *dst = reinterpret_cast<std::uint8_t *>(out.row(y));
+
+        int x = 0;
+        for (; x + 32 <= bytes; x += 32) {
+            __m256i const c0 = blurDivide8(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(s + x)), multiplier8);
+            __m256i const c1 = blurDivide8(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(s + x + 8)), multiplier8);
+            __m256i const c2 = blurDivide8(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(s + x + 16)), multiplier8);
+            __m256i const c3 = blurDivide8(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(s + x + 24)), multiplier8);
+
+            // the packs interleave the 128 bit lanes, put them back in order
+            __m256i const packed = _mm256_packus_epi16(_mm256_packus_epi32(c0, c1), _mm256_packus_epi32(c2, c3));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + x),
+                                _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7)));
+        }
+
+        for (; x < bytes; ++x)
+            dst[x] = static_cast<std::uint8_t>(blurDivide(s[x], multiplier));
+
+        accumulateRow(s, bytes, reinterpret_cast<std::uint8_t const *>(in.row(clampIndex(y + radius + 1, in.height))),
+                      reinterpret_cast<std::uint8_t const *>(in.row(clampIndex(y - radius, in.height))));
+    }
+}
+
+IMAGE_KERNELS_TARGET("avx2")
+void resizeBilinear(ConstImageView in, ImageView out, int rowBegin, int rowEnd)
+{
+    std::vector<std::uint32_t> interpolated(static_cast<std::size_t>(in.width));
+
+    for (int y = rowBegin; y < rowEnd; ++y) {
+        BilinearSample const s = bilinearSample(y, out.height, in.height);
+
+        blendRowAvx2(in.row(s.index), in.row(std::min(s.index + 1, in.height - 1)),
+                     interpolated.data(), in.width, s.weight);
+
+        resizeRowHorizontal(interpolated.data(), in.width, out.row(y), out.width);
+    }
+}
+
+//! channels of 2 adjacent pixels as floats
+IMAGE_KERNELS_TARGET("avx2")
+inline __m256 loadPixels2(std::uint32_t const *p)
+{
+    return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<__m128i const *>(p))));
+}
+
+IMAGE_KERNELS_TARGET("avx2")
+void convolve3x3(ConstImageView in, ImageView out, float const *kernel, int rowBegin, int rowEnd)
+{
+    __m256 k[9];
+    for (int i = 0; i < 9; ++i)
+        k[i] = _mm256_set1_ps(kernel[i]);
+
+    __m128i const alphaShuffle = _mm_setr_epi8(3, 3, 3, 3, 7, 7, 7, 7, 11, 11, 11, 11, 15, 15, 15, 15);
+
+    for (int y = rowBegin; y < rowEnd; ++y) {
+        std::uint32_t const *rows[3] = {
+            in.row(clampIndex(y - 1, in.height)),
+            in.row(y),
+            in.row(clampIndex(y + 1, in.height)),
+        };
+
+        std::uint32_t *dst = out.row(y);
+
+        dst[0] = convolvePixel(in, 0, y, kernel);
+
+        int x = 1;
+        for (; x + 2 <= in.width - 1; x += 2) {
+            __m256 acc = _mm256_setzero_ps();
+
+            for (int ky = 0; ky < 3; ++ky) {
+                for (int kx = 0; kx < 3; ++kx)
+                    acc = _mm256_add_ps(acc, _mm256_mul_ps(k[ky * 3 + kx], loadPixels2(rows[ky] + x + kx - 1)));
+            }
+
+            // clamped in float: _mm_packus_epi16 reads its input as signed words
+            acc = _mm256_min_ps(_mm256_max_ps(acc, _mm256_setzero_ps()), _mm256_set1_ps(255.0f));
+
+            __m256i const channels = _mm256_cvtps_epi32(acc);
+
+            __m128i const words  = _mm_packus_epi32(_mm256_castsi256_si128(channels), _mm256_extracti128_si256(channels, 1));
+            __m128i const packed = _mm_packus_epi16(words, _mm_setzero_si128());
+            __m128i const result = _mm_min_epu8(packed, _mm_shuffle_epi8(packed, alphaShuffle));
+
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + x), result);
+        }
+
+        for (; x < in.width; ++x)
+            dst[x] = convolvePixel(in, x, y, kernel);
+    }
+}
+
+} // namespace
+
+ImageKernels const *imagekernels::avx2Kernels()
+{
+    static ImageKernels const kernels = {
+        "avx2",
+        blend,
+        grayscale,
+        threshold,
+        nullptr,
+        boxBlurVertical,
+        resizeBilinear,
+        convolve3x3,
+        nullptr,
+        nullptr,
+    };
+
+    return &kernels;
+}
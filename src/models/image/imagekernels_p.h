@@ -0,0 +1,114 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "imagekernels.h"
+
+// Shared by the scalar and the vectorized kernels, which use the same
+// integer arithmetic so that every implementation gives the same bytes.
+
+// The vectorized kernels are marked with the instruction set they use
+// instead of building their files with -msse4.1/-mavx2: the inline
+// helpers below and the std templates are emitted as weak symbols in
+// every object file, and the linker may keep any one of the copies.
+#if defined(__GNUC__)
+#define IMAGE_KERNELS_TARGET(isa) __attribute__((target(isa)))
+#else
+#define IMAGE_KERNELS_TARGET(isa)
+#endif
+
+namespace imagekernels {
+
+//! Luminance weights of R, G and B, summing to 256.
+constexpr int LumaR = 77;
+constexpr int LumaG = 150;
+constexpr int LumaB = 29;
+
+inline int luminance(std::uint32_t p)
+{
+    return ((p >> 16 & 0xff) * LumaR + (p >> 8 & 0xff) * LumaG + (p & 0xff) * LumaB) >> 8;
+}
+
+//! (a * (256 - w) + b * w + 128) >> 8 on every channel
+inline std::uint32_t lerp(std::uint32_t a, std::uint32_t b, int w)
+{
+    std::uint32_t const iw = 256 - w;
+
+    std::uint32_t const rb = ((a & 0x00ff00ff) * iw + (b & 0x00ff00ff) * w + 0x00800080) >> 8 & 0x00ff00ff;
+    std::uint32_t const ag = (((a >> 8) & 0x00ff00ff) * iw + ((b >> 8) & 0x00ff00ff) * w + 0x00800080) & 0xff00ff00;
+
+    return rb | ag;
+}
+
+//! Fixed point reciprocal used to divide the box blur sums by the window size.
+inline std::uint32_t blurMultiplier(int radius)
+{
+    int const n = 2 * radius + 1;
+    return static_cast<std::uint32_t>((65536 + n / 2) / n);
+}
+
+inline std::uint32_t blurDivide(std::uint32_t sum, std::uint32_t multiplier)
+{
+    return (sum * multiplier + 32768) >> 16;
+}
+
+constexpr float ByteToFloat = 1.0f / 255.0f;
+
+//! 与maxps/minps相同的比较顺序，NaN得到0
+inline std::uint8_t floatToByte(float value)
+{
+    value = value * 255.0f;
+    value = value > 0.0f ? value : 0.0f;
+    value = value < 255.0f ? value : 255.0f;
+
+    return static_cast<std::uint8_t>(std::lrint(value));
+}
+
+inline int clampIndex(int i, int size)
+{
+    return std::min(std::max(i, 0), size - 1);
+}
+
+//! Source coordinate of the first sample and the 8 bit weight of the second.
+struct BilinearSample
+{
+    int index;
+    int weight;
+};
+
+//! Pixel centre aligned mapping from out to in, in 16.16 fixed point.
+inline BilinearSample bilinearSample(int outIndex, int outSize, int inSize)
+{
+    std::int64_t const position =
+            ((2 * static_cast<std::int64_t>(outIndex) + 1) * inSize * 65536) / (2 * outSize) - 32768;
+
+    if (position <= 0)
+        return { 0, 0 };
+
+    int index = static_cast<int>(position >> 16);
+    int weight = static_cast<int>((position & 0xffff) >> 8);
+
+    if (index >= inSize - 1)
+        return { inSize - 1, 0 };
+
+    return { index, weight };
+}
+
+//! Horizontal pass of the bilinear resize on one interpolated row.
+void resizeRowHorizontal(std::uint32_t const *in, int inWidth, std::uint32_t *out, int outWidth);
+
+//! The scalar kernels, the vectorized ones fall back to them for the tails.
+void blendRow(std::uint32_t const *a, std::uint32_t const *b, std::uint32_t *out, int count, int weight);
+void grayscaleRow(std::uint32_t const *in, std::uint32_t *out, int count);
+void thresholdRow(std::uint32_t const *in, std::uint32_t *out, int count, int level);
+std::uint32_t convolvePixel(ConstImageView in, int x, int y, float const *kernel);
+void unpackRow(std::uint8_t const *in, int channels, float *const *planes, int count);
+void packRow(float const *const *planes, int channels, std::uint8_t *out, int count);
+
+//! Vectorized implementations, null when not compiled in.
+ImageKernels const *sse41Kernels();
+ImageKernels const *avx2Kernels();
+
+} // namespace imagekernels
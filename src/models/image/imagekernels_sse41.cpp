@@ -0,0 +1,415 @@
+#include "imagekernels.h"
+#include "imagekernels_p.h"
+
+#include <cstring>
+#include <vector>
+
+#include <smmintrin.h>
+
+// Only the functions marked with IMAGE_KERNELS_TARGET use SSE4.1, they
+// are called when the CPU supports it.
+
+using namespace imagekernels;
+
+namespace {
+
+// luminance weights for the B, G, R, A bytes of a pixel, as 16 bit lanes
+IMAGE_KERNELS_TARGET("sse4.1")
+__m128i lumaWeights()
+{
+    return _mm_setr_epi16(LumaB, LumaG, LumaR, 0, LumaB, LumaG, LumaR, 0);
+}
+
+//! luminance of 4 pixels, one per 32 bit lane
+IMAGE_KERNELS_TARGET("sse4.1")
+inline __m128i luminance4(__m128i pixels, __m128i weights)
+{
+    __m128i const zero = _mm_setzero_si128();
+
+    __m128i const lo = _mm_madd_epi16(_mm_unpacklo_epi8(pixels, zero), weights);
+    __m128i const hi = _mm_madd_epi16(_mm_unpackhi_epi8(pixels, zero), weights);
+
+    return _mm_srli_epi32(_mm_hadd_epi32(lo, hi), 8);
+}
+
+IMAGE_KERNELS_TARGET("sse4.1")
+inline void blendRowSse41(std::uint32_t const *a, std::uint32_t const *b, std::uint32_t *out, int count, int weight)
+{
+    __m128i const zero = _mm_setzero_si128();
+    __m128i const w    = _mm_set1_epi16(static_cast<short>(weight));
+    __m128i const iw   = _mm_set1_epi16(static_cast<short>(256 - weight));
+    __m128i const half = _mm_set1_epi16(128);
+
+    int x = 0;
+    for (; x + 4 <= count; x += 4) {
+        __m128i const pa = _mm_loadu_si128(reinterpret_cast<__m128i const *>(a + x));
+        __m128i const pb = _mm_loadu_si128(reinterpret_cast<__m128i const *>(b + x));
+
+        // a * (256 - w) + b * w + 128 never exceeds 16 bits
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(pa, zero), iw),
+                                   _mm_mullo_epi16(_mm_unpacklo_epi8(pb, zero), w));
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(pa, zero), iw),
+                                   _mm_mullo_epi16(_mm_unpackhi_epi8(pb, zero), w));
+
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, half), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, half), 8);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + x), _mm_packus_epi16(lo, hi));
+    }
+
+    blendRow(a + x, b + x, out + x, count - x, weight);
+}
+
+IMAGE_KERNELS_TARGET("sse4.1")
+void blend(ConstImageView a, ConstImageView b, ImageView out, int weight, int rowBegin, int rowEnd)
+{
+    for (int y = rowBegin; y < rowEnd; ++y)
+        blendRowSse41(a.row(y), b.row(y), out.row(y), out.width, weight);
+}
+
+IMAGE_KERNELS_TARGET("sse4.1")
+void grayscale(ConstImageView in, ImageView out, int rowBegin, int rowEnd)
+{
+    __m128i const weights   = lumaWeights();
+    __m128i const alphaMask = _mm_set1_epi32(static_cast<int>(0xff000000));
+    __m128i const replicate = _mm_set1_epi32(0x010101);
+
+    for (int y = rowBegin; y < rowEnd; ++y) {
+        std::uint32_t const *src = in.row(y);
+        std::uint32_t *dst = out.row(y);
+
+        int x = 0;
+        for (; x + 4 <= out.width; x += 4) {
+            __m128i const pixels = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + x));
+            __m128i const gray   = _mm_mullo_epi32(luminance4(pixels, weights), replicate);
+
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x),
+                             _mm_or_si128(gray, _mm_and_si128(pixels, alphaMask)));
+        }
+
+        grayscaleRow(src + x, dst + x, out.width - x);
+    }
+}
+
+IMAGE_KERNELS_TARGET("sse4.1")
+void threshold(ConstImageView in, ImageView out, int level, int rowBegin, int rowEnd)
+{
+    __m128i const weights = lumaWeights();
+    __m128i const limit   = _mm_set1_epi32(level - 1);
+    __m128i const black   = _mm_set1_epi32(static_cast<int>(0xff000000));
+
+    for (int y = rowBegin; y < rowEnd; ++y) {
+        std::uint32_t const *src = in.row(y);
+        std::uint32_t *dst = out.row(y);
+
+        int x = 0;
+        for (; x + 4 <= out.width; x += 4) {
+            __m128i const pixels = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + x));
+            __m128i const above  = _mm_cmpgt_epi32(luminance4(pixels, weights), limit);
+
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x), _mm_or_si128(above, black));
+        }
+
+        thresholdRow(src + x, dst + x, out.width - x, level);
+    }
+}
+
+IMAGE_KERNELS_TARGET("sse4.1")
+inline __m128i loadPixel(std::uint32_t p)
+{
+    return _mm_cvtepu8_epi32(_mm_cvtsi32_si128(static_cast<int>(p)));
+}
+
+IMAGE_KERNELS_TARGET("sse4.1")
+inline std::uint32_t storePixel(__m128i channels)
+{
+    __m128i const packed = _mm_packus_epi16(_mm_packus_epi32(channels, channels), _mm_setzero_si128());
+    return static_cast<std::uint32_t>(_mm_cvtsi128_si32(packed));
+}
+
+//! (sum * multiplier + 32768) >> 16 on 32 bit lanes
+IMAGE_KERNELS_TARGET("sse4.1")
+inline __m128i blurDivide4(__m128i sum, __m128i multiplier)
+{
+    return _mm_srli_epi32(_mm_add_epi32(_mm_mullo_epi32(sum, multiplier), _mm_set1_epi32(32768)), 16);
+}
+
+IMAGE_KERNELS_TARGET("sse4.1")
+void boxBlurHorizontal(ConstImageView in, ImageView out, int radius, int rowBegin, int rowEnd)
+{
+    __m128i const multiplier = _mm_set1_epi32(static_cast<int>(blurMultiplier(radius)));
+    int const width = in.width;
+
+    for (int y = rowBegin; y < rowEnd; ++y) {
+        std::uint32_t const *src = in.row(y);
+        std::uint32_t *dst = out.row(y);
+
+        __m128i sum = _mm_setzero_si128();
+        for (int i = -radius; i <= radius; ++i)
+            sum = _mm_add_epi32(sum, loadPixel(src[clampIndex(i, width)]));
+
+        for (int x = 0; x < width; ++x) {
+            dst[x] = storePixel(blurDivide4(sum, multiplier));
+
+            sum = _mm_add_epi32(sum, loadPixel(src[clampIndex(x + radius + 1, width)]));
+            sum = _mm_sub_epi32(sum, loadPixel(src[clampIndex(x - radius, width)]));
+        }
+    }
+}
+
+//! s += add - subtract on every channel, 16 channels at a time
+IMAGE_KERNELS_TARGET("sse4.1")
+void accumulateRow(std::uint32_t *s, int bytes, std::uint8_t const *add, std::uint8_t const *subtract)
+{
+    __m128i const zero = _mm_setzero_si128();
+
+    int x = 0;
+    for (; x + 16 <= bytes; x += 16) {
+        __m128i const a = _mm_loadu_si128(reinterpret_cast<__m128i const *>(add + x));
+        __m128i const b = subtract ? _mm_loadu_si128(reinterpret_cast<__m128i const *>(subtract + x)) : zero;
+
+        // a - b as 16 bit lanes, then sign extended to 32 bits
+        __m128i const lo = _mm_sub_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+        __m128i const hi = _mm_sub_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+
+        __m128i const d[4] = {
+            _mm_cvtepi16_epi32(lo),
+            _mm_cvtepi16_epi32(_mm_srli_si128(lo, 8)),
+            _mm_cvtepi16_epi32(hi),
+            _mm_cvtepi16_epi32(_mm_srli_si128(hi, 8)),
+        };
+
+        for (int i = 0; i < 4; ++i) {
+            __m128i *sum = reinterpret_cast<__m128i *>(s + x + 4 * i);
+            _mm_storeu_si128(sum, _mm_add_epi32(_mm_loadu_si128(sum), d[i]));
+        }
+    }
+
+    for (; x < bytes; ++x)
+        s[x] += add[x] - (subtract ? subtract[x] : 0);
+}
+
+IMAGE_KERNELS_TARGET("sse4.1")
+void boxBlurVertical(ConstImageView in, ImageView out, int radius, int rowBegin, int rowEnd)
+{
+    __m128i const multiplier = _mm_set1_epi32(static_cast<int>(blurMultiplier(radius)));
+    int const bytes = in.width * 4;
+
+    std::vector<std::uint32_t> sums(static_cast<std::size_t>(bytes), 0);
+    std::uint32_t *s = sums.data();
+
+    for (int i = -radius; i <= radius; ++i)
+        accumulateRow(s, bytes, reinterpret_cast<std::uint8_t const *>(in.row(clampIndex(rowBegin + i, in.height))), nullptr);
+
+    for (int y = rowBegin; y < rowEnd; ++y) {
+        std::uint32_t *dst = out.row(y);
+
+        for (int x = 0; x < in.width; x += 4) {
+            // 4 pixels, the 16 running sums of their channels
+            if (x + 4 <= in.width) {
+                __m128i const c0 = blurDivide4(_mm_loadu_si128(reinterpret_cast<__m128i const *>(s + 4 * x)), multiplier);
+                __m128i const c1 = blurDivide4(_mm_loadu_si128(reinterpret_cast<__m128i const *>(s + 4 * x + 4)), multiplier);
+                __m128i const c2 = blurDivide4(_mm_loadu_si128(reinterpret_cast<__m128i const *>(s + 4 * x + 8)), multiplier);
+                __m128i const c3 = blurDivide4(_mm_loadu_si128(reinterpret_cast<__m128i const *>(s + 4 * x + 12)), multiplier);
+
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x),
+                                 _mm_packus_epi16(_mm_packus_epi32(c0, c1), _mm_packus_epi32(c2, c3)));
+            } else {
+                for (int i = x; i < in.width; ++i) {
+                    dst[i] = storePixel(blurDivide4(_mm_loadu_si128(reinterpret_cast<__m128i const *>(s + 4 * i)),
+                                                    multiplier));
+                }
+            }
+        }
+
+        accumulateRow(s, bytes, reinterpret_cast<std::uint8_t const *>(in.row(clampIndex(y + radius + 1, in.height))),
+                      reinterpret_cast<std::uint8_t const *>(in.row(clampIndex(y - radius, in.height))));
+    }
+}
+
+IMAGE_KERNELS_TARGET("sse4.1")
+void resizeBilinear(ConstImageView in, ImageView out, int rowBegin, int rowEnd)
+{
+    std::vector<std::uint32_t> interpolated(static_cast<std::size_t>(in.width));
+
+    for (int y = rowBegin; y < rowEnd; ++y) {
+        BilinearSample const s = bilinearSample(y, out.height, in.height);
+
+        blendRowSse41(in.row(s.index), in.row(std::min(s.index + 1, in.height - 1)),
+                      interpolated.data(), in.width, s.weight);
+
+        resizeRowHorizontal(interpolated.data(), in.width, out.row(y), out.width);
+    }
+}
+
+//! clamps the colour channels of a pixel (B, G, R, A bytes) to its alpha
+IMAGE_KERNELS_TARGET("sse4.1")
+inline __m128i premultiplyClamp(__m128i pixels)
+{
+    __m128i const alpha = _mm_shuffle_epi8(pixels, _mm_setr_epi8(3, 3, 3, 3, 7, 7, 7, 7,
+                                                                 11, 11, 11, 11, 15, 15, 15, 15));
+    return _mm_min_epu8(pixels, alpha);
+}
+
+IMAGE_KERNELS_TARGET("sse4.1")
+void convolve3x3(ConstImageView in, ImageView out, float const *kernel, int rowBegin, int rowEnd)
+{
+    __m128 k[9];
+    for (int i = 0; i < 9; ++i)
+        k[i] = _mm_set1_ps(kernel[i]);
+
+    for (int y = rowBegin; y < rowEnd; ++y) {
+        std::uint32_t const *rows[3] = {
+            in.row(clampIndex(y - 1, in.height)),
+            in.row(y),
+            in.row(clampIndex(y + 1, in.height)),
+        };
+
+        std::uint32_t *dst = out.row(y);
+
+        dst[0] = convolvePixel(in, 0, y, kernel);
+
+        for (int x = 1; x < in.width - 1; ++x) {
+            __m128 acc = _mm_setzero_ps();
+
+            for (int ky = 0; ky < 3; ++ky) {
+                for (int kx = 0; kx < 3; ++kx) {
+                    __m128 const c = _mm_cvtepi32_ps(loadPixel(rows[ky][x + kx - 1]));
+                    acc = _mm_add_ps(acc, _mm_mul_ps(k[ky * 3 + kx], c));
+                }
+            }
+
+            // clamped in float: _mm_packus_epi16 reads its input as signed words
+            acc = _mm_min_ps(_mm_max_ps(acc, _mm_setzero_ps()), _mm_set1_ps(255.0f));
+
+            __m128i const channels = _mm_cvtps_epi32(acc);
+            __m128i const packed = _mm_packus_epi16(_mm_packus_epi32(channels, channels), _mm_setzero_si128());
+
+            dst[x] = static_cast<std::uint32_t>(_mm_cvtsi128_si32(premultiplyClamp(packed)));
+        }
+
+        if (in.width > 1)
+            dst[in.width - 1] = convolvePixel(in, in.width - 1, y, kernel);
+    }
+}
+
+//! groups the bytes of 4 pixels by channel: c0 c0 c0 c0 c1 c1 c1 c1 ...
+IMAGE_KERNELS_TARGET("sse4.1")
+inline __m128i groupChannels(int channels)
+{
+    switch (channels) {
+    case 4:
+        return _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+    case 3:
+        return _mm_setr_epi8(0, 3, 6, 9, 1, 4, 7, 10, 2, 5, 8, 11, -1, -1, -1, -1);
+    default:
+        return _mm_setr_epi8(0, 1, 2, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    }
+}
+
+//! the inverse of groupChannels
+IMAGE_KERNELS_TARGET("sse4.1")
+inline __m128i interleaveChannels(int channels)
+{
+    switch (channels) {
+    case 4:
+        return _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+    case 3:
+        return _mm_setr_epi8(0, 4, 8, 1, 5, 9, 2, 6, 10, 3, 7, 11, -1, -1, -1, -1);
+    default:
+        return _mm_setr_epi8(0, 1, 2, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    }
+}
+
+IMAGE_KERNELS_TARGET("sse4.1")
+void unpackToFloat(std::uint8_t const *in, int channels, float *const *planes, int count)
+{
+    __m128i const shuffle = groupChannels(channels);
+    __m128 const scale = _mm_set1_ps(ByteToFloat);
+
+    // 4 pixels at a time, each load reads 16 bytes
+    int x = 0;
+    for (; x + 4 <= count && x * channels + 16 <= count * channels; x += 4) {
+        __m128i grouped = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const *>(in + x * channels)), shuffle);
+
+        for (int c = 0; c < channels; ++c) {
+            _mm_storeu_ps(planes[c] + x, _mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(grouped)), scale));
+            grouped = _mm_srli_si128(grouped, 4);
+        }
+    }
+
+    float *rest[4];
+    for (int c = 0; c < channels; ++c)
+        rest[c] = planes[c] + x;
+
+    unpackRow(in + x * channels, channels, rest, count - x);
+}
+
+//! channel c of the 4 pixels from x on, one per 32 bit lane, 0 past the last channel;
+//! operand order as in floatToByte
+IMAGE_KERNELS_TARGET("sse4.1")
+inline __m128i packChannel(float const *const *planes, int channels, int c, int x)
+{
+    if (c >= channels)
+        return _mm_setzero_si128();
+
+    __m128 const scale = _mm_set1_ps(255.0f);
+
+    __m128 value = _mm_mul_ps(_mm_loadu_ps(planes[c] + x), scale);
+    value = _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), scale);
+
+    return _mm_cvtps_epi32(value);
+}
+
+IMAGE_KERNELS_TARGET("sse4.1")
+void packFromFloat(float const *const *planes, int channels, std::uint8_t *out, int count)
+{
+    __m128i const shuffle = interleaveChannels(channels);
+
+    int x = 0;
+    for (; x + 4 <= count; x += 4) {
+        __m128i const words0 = _mm_packus_epi32(packChannel(planes, channels, 0, x), packChannel(planes, channels, 1, x));
+        __m128i const words1 = _mm_packus_epi32(packChannel(planes, channels, 2, x), packChannel(planes, channels, 3, x));
+        __m128i const pixels = _mm_shuffle_epi8(_mm_packus_epi16(words0, words1), shuffle);
+
+        std::uint8_t *dst = out + x * channels;
+
+        if (channels == 4) {
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), pixels);
+        } else if (channels == 3) {
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(dst), pixels);
+
+            int const last = _mm_cvtsi128_si32(_mm_srli_si128(pixels, 8));
+            std::memcpy(dst + 8, &last, 4);
+        } else {
+            int const gray = _mm_cvtsi128_si32(pixels);
+            std::memcpy(dst, &gray, 4);
+        }
+    }
+
+    float const *rest[4];
+    for (int c = 0; c < channels; ++c)
+        rest[c] = planes[c] + x;
+
+    packRow(rest, channels, out + x * channels, count - x);
+}
+
+} // namespace
+
+ImageKernels const *imagekernels::sse41Kernels()
+{
+    static ImageKernels const kernels = {
+        "sse4.1",
+        blend,
+        grayscale,
+        threshold,
+        boxBlurHorizontal,
+        boxBlurVertical,
+        resizeBilinear,
+        convolve3x3,
+        unpackToFloat,
+        packFromFloat,
+    };
+
+    return &kernels;
+}
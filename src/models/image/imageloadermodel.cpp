@@ -1,9 +1,23 @@
 #include "imageloadermodel.h"
-#include "pixmapdata.h"
+#include "imagedata.h"
+#include "decodecache.h"
 
 #include <QEvent>
 #include <QDir>
 #include <QFileDialog>
+#include <QImage>
+
+//! 经过共享的解码缓存：其他节点或之前加载的场景已解码过的文件不再解码
+static QImage readImage(QString const &fileName, QSize const &maxSize = QSize())
+{
+    return DecodeCache::instance().image(fileName, maxSize);
+}
+
+//! 在解码的工作线程中一并算出内容哈希，GUI线程查输出缓存时不再遍历像素
+static std::shared_ptr<ImageData> readImageData(QString const &fileName)
+{
+    return ImageData::hashed(readImage(fileName));
+}
 
 ImageLoaderModel::ImageLoaderModel()
     : _label(new QLabel("Double click to load image"))
@@ -19,6 +33,35 @@ ImageLoaderModel::ImageLoaderModel()
     _label->installEventFilter(this);
 }
 
+QJsonObject ImageLoaderModel::save() const
+{
+    QJsonObject modelJson = NodeDataModel::save();
+
+    if (!_fileName.isEmpty())
+        modelJson["file"] = _fileName;
+
+    return modelJson;
+}
+
+void ImageLoaderModel::restore(QJsonObject const &modelJson)
+{
+    QString const fileName = modelJson["file"].toString();
+
+    // full resolution only once there is a consumer, the batch runner
+    // loads it itself with loadFile()
+    if (!fileName.isEmpty())
+        loadImage(fileName);
+}
+
+void ImageLoaderModel::loadFile(QString const &fileName)
+{
+    restart();
+
+    setImage(fileName, readImageData(fileName));
+
+    emit dataUpdated(0);
+}
+
 unsigned int ImageLoaderModel::nPorts(PortType portType) const
 {
     unsigned int result = 1;
@@ -45,32 +88,113 @@ bool ImageLoaderModel::eventFilter(QObject *object, QEvent *event)
         int h = _label->height();
 
         if (event->type() == QEvent::MouseButtonPress) {
+            auto dialog = new QFileDialog(nullptr,
+                                          tr("Open Image"),
+                                          QDir::homePath(),
+                                          tr("Image Files (*.png *.jpg *.jpeg *.bmp *.tif *.tiff)"));
+            dialog->setAttribute(Qt::WA_DeleteOnClose);
+            dialog->setFileMode(QFileDialog::ExistingFile);
+
+            connect(dialog, &QFileDialog::fileSelected,
+                    this, [this](QString const &fileName) { loadImage(fileName); });
 
-            QString fileName =
-                    QFileDialog::getOpenFileName(nullptr,
-                                                 tr("Open Image"),
-                                                 QDir::homePath(),
-                                                 tr("Image Files (*.png *.jpg *.bmp)"));
-            _pixmap = QPixmap(fileName);
-            _label->setPixmap(_pixmap.scaled(w, h, Qt::KeepAspectRatio));
-            emit dataUpdated(0);
+            dialog->open();
 
             return true;
         } else if (event->type() == QEvent::Resize) {
-            if (!_pixmap.isNull())
-                _label->setPixmap(_pixmap.scaled(w, h, Qt::KeepAspectRatio));
+            if (!_preview.isNull())
+                _label->setPixmap(_preview.scaled(w, h, Qt::KeepAspectRatio));
         }
     }
 
     return false;
 }
 
+void ImageLoaderModel::outputConnectionCreated(Connection const &)
+{
+    ++_consumers;
+
+    if ((!_imageData || _imageData->isNull()) && !_fileName.isEmpty() && !_loading)
+        loadFullResolution();
+}
+
+void ImageLoaderModel::outputConnectionDeleted(Connection const &)
+{
+    --_consumers;
+}
+
+NodeTask ImageLoaderModel::loadImage(QString fileName)
+{
+    restart();
+
+    _loading = true;
+    _fileName = fileName;
+    _imageData.reset();
+    _preview = QPixmap();
+    _label->setText(tr("Loading..."));
+
+    // QPixmap只能在GUI线程上使用，工作线程中解码为QImage
+    QImage preview = co_await runAsync([fileName] {
+        return readImage(fileName, QSize(PreviewExtent, PreviewExtent));
+    });
+
+    setPreview(preview);
+
+    if (_consumers > 0 && !preview.isNull())
+        _imageData = co_await runAsync([fileName] { return readImageData(fileName); });
+
+    _loading = false;
+
+    emit dataUpdated(0);
+}
+
+NodeTask ImageLoaderModel::loadFullResolution()
+{
+    restart();
+
+    _loading = true;
+
+    QString const fileName = _fileName;
+    _imageData = co_await runAsync([fileName] { return readImageData(fileName); });
+    _loading = false;
+
+    emit dataUpdated(0);
+}
+
+void ImageLoaderModel::setImage(QString const &fileName, std::shared_ptr<ImageData> imageData)
+{
+    _loading = false;
+    _fileName = fileName;
+    _imageData = std::move(imageData);
+
+    QImage const &image = _imageData->image();
+
+    if (image.width() > PreviewExtent || image.height() > PreviewExtent)
+        setPreview(image.scaled(PreviewExtent, PreviewExtent, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+    else
+        setPreview(image);
+}
+
+void ImageLoaderModel::setPreview(QImage const &preview)
+{
+    _preview = QPixmap::fromImage(preview);
+
+    if (_preview.isNull())
+        _label->setText(tr("Cannot load image"));
+    else
+        _label->setPixmap(_preview.scaled(_label->width(), _label->height(), Qt::KeepAspectRatio));
+}
+
 NodeDataType ImageLoaderModel::dataType(PortType, PortIndex) const
 {
-    return PixmapData().type();
+    return ImageData().type();
 }
 
 std::shared_ptr<NodeData> ImageLoaderModel::outData(PortIndex)
 {
-    return std::make_shared<PixmapData>(_pixmap);
+    // 同一张图片总是返回同一份数据，下游共享其金字塔与哈希
+    if (!_imageData)
+        _imageData = std::make_shared<ImageData>();
+
+    return _imageData;
 }
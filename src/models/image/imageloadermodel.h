@@ -4,14 +4,20 @@
 
 #include <QObject>
 #include <QLabel>
+#include <QImage>
 
 #include "nodedata.h"
-#include "nodedatamodel.h"
+#include "coroutinenodedatamodel.h"
+#include "imagedata.h"
 
 /**
  * @brief 图片加载模型
+ *
+ * 图片在线程池中用QImageReader解码：先按预览尺寸缩小解码用于显示，
+ * 全分辨率图片只在输出端口有下游连接时才解码（只解码一次）。
+ * 解码结果经由DecodeCache在所有节点间共享
  */
-class ImageLoaderModel : public NodeDataModel
+class ImageLoaderModel : public CoroutineNodeDataModel
 {
     Q_OBJECT
 
@@ -19,6 +25,10 @@ public:
     ImageLoaderModel();
     virtual ~ImageLoaderModel() {}
 
+public:
+    QJsonObject save() const override;
+    void restore(QJsonObject const &modelJson) override;
+
 public:
     QString caption() const override { return QString("Image Source"); }
     QString name() const override { return QString("ImageLoaderModel"); }
@@ -32,16 +42,43 @@ public:
 
     std::shared_ptr<NodeData> outData(PortIndex port) override;
 
-    void setInData(std::shared_ptr<NodeData>, int) override { }
-
     QWidget *embeddedWidget() override { return _label; }
 
     bool resizable() const override { return true; }
 
+public slots:
+    void outputConnectionCreated(Connection const &) override;
+    void outputConnectionDeleted(Connection const &) override;
+
+public:
+    QString fileName() const { return _fileName; }
+
+    //! 同步加载图片并更新输出（批处理中加载场景后或逐个替换输入时使用）
+    void loadFile(QString const &fileName);
+
 protected:
     bool eventFilter(QObject *object, QEvent *event) override;
 
 private:
+    //! 在线程池中解码预览，有下游时再解码全分辨率图片，回到GUI线程后更新输出
+    NodeTask loadImage(QString fileName);
+
+    //! 在线程池中解码当前文件的全分辨率图片
+    NodeTask loadFullResolution();
+
+    void setImage(QString const &fileName, std::shared_ptr<ImageData> imageData);
+    void setPreview(QImage const &preview);
+
+private:
+    static constexpr int PreviewExtent = 512;
+
     QLabel *_label;
-    QPixmap _pixmap;
+    QString _fileName;
+
+    //! 全分辨率图片及其哈希，没有下游时为空
+    std::shared_ptr<ImageData> _imageData;
+    QPixmap _preview;
+
+    int _consumers = 0;
+    bool _loading = false;
 };
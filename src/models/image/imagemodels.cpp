@@ -0,0 +1,57 @@
+#include "imagemodels.h"
+
+#include "imageloadermodel.h"
+#include "imagesequencemodel.h"
+#include "mappedimagemodel.h"
+#include "imageshowmodel.h"
+#include "imagefilters.h"
+#include "imagegammamodel.h"
+#include "imageformats.h"
+#include "imagedata.h"
+#include "tiledimagedata.h"
+#include "pixmapdata.h"
+
+// QPixmap只能在GUI线程上使用，以下转换也只能在GUI线程上执行
+
+static SharedNodeData pixmapToImage(SharedNodeData data)
+{
+    auto pixmapData = std::dynamic_pointer_cast<PixmapData>(data);
+    if (!pixmapData)
+        return nullptr;
+
+    return std::make_shared<ImageData>(pixmapData->pixmap().toImage());
+}
+
+static SharedNodeData imageToPixmap(SharedNodeData data)
+{
+    // 分块图片在这里拼出原始分辨率
+    QImage const image = imageFromData(data);
+    if (image.isNull())
+        return nullptr;
+
+    return std::make_shared<PixmapData>(QPixmap::fromImage(image));
+}
+
+std::shared_ptr<DataModelRegistry> registerImageModels()
+{
+    auto ret = std::make_shared<DataModelRegistry>();
+    ret->registerModel<ImageShowModel>();
+    ret->registerModel<ImageLoaderModel>();
+    ret->registerModel<MappedImageModel>();
+    ret->registerModel<ImageSequenceModel>();
+
+    ret->registerModel<ImageBlurModel>("Processing");
+    ret->registerModel<ImageResizeModel>("Processing");
+    ret->registerModel<ImageGrayscaleModel>("Processing");
+    ret->registerModel<ImageThresholdModel>("Processing");
+    ret->registerModel<ImageBlendModel>("Processing");
+    ret->registerModel<ImageConvolutionModel>("Processing");
+    ret->registerModel<ImageGammaModel>("Processing");
+
+    ret->registerTypeConverter({ PixmapData().type(), ImageData().type() }, pixmapToImage);
+    ret->registerTypeConverter({ ImageData().type(), PixmapData().type() }, imageToPixmap);
+
+    registerImageFormatConverters(*ret);
+
+    return ret;
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <memory>
+
+#include "datamodelregistry.h"
+
+//! 注册图片相关的全部模型，编辑器与批处理程序共用
+std::shared_ptr<DataModelRegistry> registerImageModels();
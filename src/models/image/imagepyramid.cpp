@@ -0,0 +1,55 @@
+#include "imagepyramid.h"
+
+#include <algorithm>
+
+ImagePyramid::ImagePyramid(QImage const &image)
+{
+    _levels.push_back(image);
+
+    if (image.isNull())
+        return;
+
+    // 每级都从上一级缩小，总开销不超过缩小一次原图的4/3
+    while (std::max(_levels.back().width(), _levels.back().height()) / 2 >= MinExtent) {
+        QImage const &previous = _levels.back();
+
+        _levels.push_back(previous.scaled(std::max(previous.width() / 2, 1),
+                                          std::max(previous.height() / 2, 1),
+                                          Qt::IgnoreAspectRatio,
+                                          Qt::SmoothTransformation));
+    }
+}
+
+int ImagePyramid::levelCount() const
+{
+    return static_cast<int>(_levels.size());
+}
+
+QImage const &ImagePyramid::level(int index) const
+{
+    return _levels[index];
+}
+
+QImage const &ImagePyramid::levelFor(QSize const &size) const
+{
+    QSize const target = _levels.front().size().scaled(size, Qt::KeepAspectRatio);
+
+    // 各级从大到小，取最后一个仍能覆盖目标尺寸的
+    std::size_t index = 0;
+    while (index + 1 < _levels.size() &&
+           _levels[index + 1].width() >= target.width() &&
+           _levels[index + 1].height() >= target.height())
+        ++index;
+
+    return _levels[index];
+}
+
+QImage ImagePyramid::scaled(QSize const &size) const
+{
+    QImage const &image = levelFor(size);
+
+    if (image.isNull() || size.isEmpty())
+        return QImage();
+
+    return image.scaled(size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+}
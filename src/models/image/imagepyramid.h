@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+
+#include <QImage>
+#include <QSize>
+
+/**
+ * @brief 图片的mip金字塔：第0级为原图，之后每级宽高减半
+ *
+ * 预览从不小于目标尺寸的最近一级缩放，而不是每次都缩放原图。
+ * 构建完成后只读，可在线程间共享。
+ */
+class ImagePyramid
+{
+public:
+    //! 最小一级的长边不小于MinExtent
+    static constexpr int MinExtent = 32;
+
+public:
+    explicit ImagePyramid(QImage const &image);
+
+    int levelCount() const;
+    QImage const &level(int index) const;
+
+    //! 按比例缩放到size之内仍不小于缩放结果的最小一级
+    QImage const &levelFor(QSize const &size) const;
+
+    //! 从最近的一级按比例缩放到size之内
+    QImage scaled(QSize const &size) const;
+
+private:
+    std::vector<QImage> _levels;
+};
@@ -0,0 +1,334 @@
+#include "imagesequencemodel.h"
+#include "imagedata.h"
+
+#include <algorithm>
+
+#include <QCollator>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QFormLayout>
+#include <QImageReader>
+#include <QPointer>
+#include <QRegularExpression>
+#include <QSignalBlocker>
+
+//! 文件名模式转为正则表达式："#"为一位数字，"%0Nd"为N位数字，"%d"为若干位数字，"*"为任意字符
+static QString patternExpression(QString const &pattern)
+{
+    static QRegularExpression const placeholder("#+|%(\\d*)d|\\*");
+
+    QString expression = "^";
+    int last = 0;
+
+    auto it = placeholder.globalMatch(pattern);
+    while (it.hasNext()) {
+        QRegularExpressionMatch const match = it.next();
+        QString const token = match.captured();
+
+        expression += QRegularExpression::escape(pattern.mid(last, match.capturedStart() - last));
+
+        if (token.startsWith('#')) {
+            expression += QString("\\d{%1}").arg(token.size());
+        } else if (token == "*") {
+            expression += ".*";
+        } else {
+            int const width = match.captured(1).toInt();
+            expression += width > 0 ? QString("\\d{%1}").arg(width) : QString("\\d+");
+        }
+
+        last = match.capturedEnd();
+    }
+
+    return expression + QRegularExpression::escape(pattern.mid(last)) + "$";
+}
+
+ImageSequenceModel::ImageSequenceModel()
+    : _widget(new QWidget),
+      _source(new QLineEdit),
+      _rate(new QSpinBox),
+      _depth(new QSpinBox),
+      _play(new QPushButton(tr("Play"))),
+      _stats(new QLabel)
+{
+    _widget->setAttribute(Qt::WA_NoSystemBackground);
+
+    _source->setPlaceholderText(tr("Directory or frame_####.png"));
+
+    _rate->setRange(0, 240);
+    _rate->setValue(25);
+    _rate->setSuffix(tr(" fps"));
+    _rate->setSpecialValueText(tr("As fast as possible"));
+
+    _depth->setRange(1, 64);
+    _depth->setValue(8);
+
+    _play->setCheckable(true);
+
+    auto form = new QFormLayout(_widget);
+    form->addRow(tr("Source"), _source);
+    form->addRow(tr("Rate"), _rate);
+    form->addRow(tr("Prefetch"), _depth);
+    form->addRow(_play);
+    form->addRow(_stats);
+
+    connect(_source, &QLineEdit::editingFinished, this, [this] {
+        // also emitted when the field just loses focus
+        if (_source->isModified())
+            setSource(_source->text());
+    });
+
+    connect(_rate, qOverload<int>(&QSpinBox::valueChanged), this, [this] {
+        if (_playing && !_waiting)
+            _timer.start(interval());
+    });
+
+    connect(_depth, qOverload<int>(&QSpinBox::valueChanged), this, &ImageSequenceModel::resetPrefetcher);
+
+    connect(_play, &QPushButton::toggled, this, [this](bool checked) {
+        if (checked)
+            play();
+        else
+            pause();
+    });
+
+    connect(&_timer, &QTimer::timeout, this, &ImageSequenceModel::advance);
+
+    updateStats();
+}
+
+ImageSequenceModel::~ImageSequenceModel() = default;
+
+QJsonObject ImageSequenceModel::save() const
+{
+    QJsonObject modelJson = NodeDataModel::save();
+
+    modelJson["source"] = _source->text();
+    modelJson["rate"] = _rate->value();
+    modelJson["depth"] = _depth->value();
+
+    return modelJson;
+}
+
+void ImageSequenceModel::restore(QJsonObject const &modelJson)
+{
+    _rate->setValue(modelJson["rate"].toInt(_rate->value()));
+    _depth->setValue(modelJson["depth"].toInt(_depth->value()));
+
+    QString const source = modelJson["source"].toString();
+
+    if (!source.isEmpty())
+        setSource(source);
+}
+
+unsigned int ImageSequenceModel::nPorts(PortType portType) const
+{
+    return portType == PortType::Out ? 1 : 0;
+}
+
+NodeDataType ImageSequenceModel::dataType(PortType, PortIndex) const
+{
+    return ImageData().type();
+}
+
+QStringList ImageSequenceModel::sequenceFiles(QString const &source)
+{
+    QFileInfo const info(source);
+
+    QDir dir;
+    QStringList names;
+
+    if (info.isDir()) {
+        dir = QDir(source);
+
+        QStringList filters;
+        for (QByteArray const &format : QImageReader::supportedImageFormats())
+            filters << "*." + QString::fromLatin1(format);
+
+        names = dir.entryList(filters, QDir::Files);
+    } else {
+        dir = info.dir();
+
+        QRegularExpression const expression(patternExpression(info.fileName()));
+
+        for (QString const &name : dir.entryList(QDir::Files)) {
+            if (expression.match(name).hasMatch())
+                names << name;
+        }
+    }
+
+    // frame_2 before frame_10
+    QCollator collator;
+    collator.setNumericMode(true);
+
+    std::sort(names.begin(), names.end(), [&collator](QString const &a, QString const &b) {
+        return collator.compare(a, b) < 0;
+    });
+
+    QStringList files;
+    for (QString const &name : names)
+        files << dir.filePath(name);
+
+    return files;
+}
+
+void ImageSequenceModel::setSource(QString const &source)
+{
+    pause();
+
+    _source->setText(source);
+
+    _files = sequenceFiles(source);
+    _frame = -1;
+    _prefetcher.reset();
+
+    resetPrefetcher();
+}
+
+void ImageSequenceModel::play()
+{
+    if (!_prefetcher) {
+        pause();
+        return;
+    }
+
+    if (_prefetcher->atEnd()) {
+        _prefetcher->seek(0);
+        _frame = -1;
+    }
+
+    _playing = true;
+    _timer.start(interval());
+
+    QSignalBlocker blocker(_play);
+    _play->setChecked(true);
+    _play->setText(tr("Pause"));
+}
+
+void ImageSequenceModel::pause()
+{
+    _playing = false;
+    _waiting = false;
+    _timer.stop();
+
+    QSignalBlocker blocker(_play);
+    _play->setChecked(false);
+    _play->setText(tr("Play"));
+}
+
+int ImageSequenceModel::prefetchDepth() const
+{
+    return _prefetcher ? _prefetcher->depth() : 0;
+}
+
+int ImageSequenceModel::bufferedFrames() const
+{
+    return _prefetcher ? _prefetcher->buffered() : 0;
+}
+
+std::size_t ImageSequenceModel::stalls() const
+{
+    return _prefetcher ? _prefetcher->stalls() : 0;
+}
+
+void ImageSequenceModel::advance()
+{
+    if (!_playing || !_prefetcher)
+        return;
+
+    if (_prefetcher->atEnd()) {
+        pause();
+        updateStats();
+        return;
+    }
+
+    // running free, the stream queues downstream set the pace; without
+    // stream consumers the decoding does, take() waits for each frame
+    if (_rate->value() == 0 && downstreamFull()) {
+        _timer.start(BackoffInterval);
+        return;
+    }
+
+    QImage image;
+    std::size_t hash;
+    int frame;
+
+    if (!_prefetcher->take(image, hash, frame)) {
+        // resumed by frameDecoded()
+        _timer.stop();
+        _waiting = true;
+
+        updateStats();
+        return;
+    }
+
+    _frame = frame;
+
+    if (!image.isNull())
+        pushOut(0, std::make_shared<ImageData>(std::move(image), hash));
+
+    if (_rate->value() == 0 && _timer.interval() != 0)
+        _timer.start(0);
+
+    updateStats();
+}
+
+void ImageSequenceModel::frameDecoded()
+{
+    if (!_waiting) {
+        updateStats();
+        return;
+    }
+
+    _waiting = false;
+    _timer.start(interval());
+
+    advance();
+}
+
+bool ImageSequenceModel::downstreamFull() const
+{
+    for (ChannelStats const &stats : streamStats()) {
+        if (stats.portType == PortType::Out && stats.depth >= stats.capacity)
+            return true;
+    }
+
+    return false;
+}
+
+int ImageSequenceModel::interval() const
+{
+    return _rate->value() > 0 ? 1000 / _rate->value() : 0;
+}
+
+void ImageSequenceModel::resetPrefetcher()
+{
+    int const position = _prefetcher ? _prefetcher->position() : 0;
+
+    _prefetcher.reset();
+
+    if (!_files.isEmpty()) {
+        QPointer<ImageSequenceModel> model(this);
+
+        auto ready = [model] {
+            QMetaObject::invokeMethod(qApp, [model] {
+                if (model)
+                    model->frameDecoded();
+            });
+        };
+
+        _prefetcher = std::make_unique<FramePrefetcher>(_files, _depth->value(), ready, position);
+    }
+
+    updateStats();
+}
+
+void ImageSequenceModel::updateStats()
+{
+    _stats->setText(tr("Frame %1 / %2\nBuffered %3 / %4, stalls %5")
+                    .arg(_frame + 1)
+                    .arg(_files.size())
+                    .arg(bufferedFrames())
+                    .arg(prefetchDepth())
+                    .arg(stalls()));
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <memory>
+
+#include <QLabel>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QStringList>
+#include <QTimer>
+
+#include "streamnodedatamodel.h"
+#include "frameprefetcher.h"
+
+/**
+ * @brief 图片序列源
+ *
+ * 源为目录（其中所有图片按文件名中的数字排序），或带编号的文件名模式：
+ * "#"表示一位数字（frame_####.png），也可以用"%04d"或通配符"*"。
+ * 帧在线程池中提前解码到环形缓冲区（FramePrefetcher），播放时逐帧pushOut()。
+ * 帧率为0时尽快播放：下游的流队列满了就等待，不丢帧，没有流式的下游时随解码的速度送出；
+ * 否则按帧率播放，队列满时丢帧。
+ * 部件上显示当前帧、缓冲区中已解码的帧数与解码停顿次数
+ */
+class ImageSequenceModel : public StreamNodeDataModel
+{
+    Q_OBJECT
+
+public:
+    ImageSequenceModel();
+    ~ImageSequenceModel() override;
+
+public:
+    QJsonObject save() const override;
+    void restore(QJsonObject const &modelJson) override;
+
+public:
+    QString caption() const override { return QString("Image Sequence"); }
+    QString name() const override { return QString("ImageSequenceModel"); }
+
+public:
+    unsigned int nPorts(PortType portType) const override;
+
+    NodeDataType dataType(PortType portType, PortIndex portIndex) const override;
+
+    QWidget *embeddedWidget() override { return _widget; }
+
+    Backpressure backpressure(PortIndex) const override { return Backpressure::Drop; }
+
+public:
+    //! 源中的所有帧文件，按编号排序
+    static QStringList sequenceFiles(QString const &source);
+
+    void setSource(QString const &source);
+
+    void play();
+    void pause();
+    bool isPlaying() const { return _playing; }
+
+    //! 预取深度、已缓冲的帧数与停顿次数，未设置源时为0
+    int prefetchDepth() const;
+    int bufferedFrames() const;
+    std::size_t stalls() const;
+
+private:
+    //! 按帧率或下游的消费速度送出下一帧
+    void advance();
+
+    //! 一帧解码完成，若正在等它则继续播放
+    void frameDecoded();
+
+    //! 通往下游流模型的队列有已满的（非流式的下游不经过队列）
+    bool downstreamFull() const;
+
+    //! 播放间隔（毫秒），尽快播放时为0
+    int interval() const;
+
+    //! 以当前的源与预取深度重建缓冲区，保留播放位置
+    void resetPrefetcher();
+    void updateStats();
+
+private:
+    //! 尽快播放而下游已满时，检查队列的间隔（毫秒）
+    static constexpr int BackoffInterval = 2;
+
+    QWidget *_widget;
+    QLineEdit *_source;
+    QSpinBox *_rate;
+    QSpinBox *_depth;
+    QPushButton *_play;
+    QLabel *_stats;
+
+    QTimer _timer;
+
+    QStringList _files;
+    std::unique_ptr<FramePrefetcher> _prefetcher;
+
+    int _frame = -1;
+    bool _playing = false;
+
+    //! 要送出的帧尚未解码完成
+    bool _waiting = false;
+};
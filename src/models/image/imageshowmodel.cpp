@@ -1,11 +1,11 @@
-#include "ImageShowModel.h"
+#include "imageshowmodel.h"
 
 #include <QEvent>
 #include <QDir>
 #include <QFileDialog>
 
 #include "datamodelregistry.h"
-#include "PixmapData.h"
+#include "imagedata.h"
 
 ImageShowModel::ImageShowModel()
     : _label(new QLabel("Image will appear here"))
@@ -43,14 +43,12 @@ unsigned int ImageShowModel::nPorts(PortType portType) const
 bool ImageShowModel::eventFilter(QObject *object, QEvent *event)
 {
     if (object == _label) {
-        int w = _label->width();
-        int h = _label->height();
-
         if (event->type() == QEvent::Resize) {
-            auto d = std::dynamic_pointer_cast<PixmapData>(_nodeData);
-            if (d) {
-                _label->setPixmap(d->pixmap().scaled(w, h, Qt::KeepAspectRatio));
-            }
+            // 放大后需要更细一级的块
+            if (_tiled && _tiled->levelFor(_label->size()) < _tiledLevel)
+                loadTiles();
+
+            updatePreview();
         }
     }
 
@@ -59,7 +57,7 @@ bool ImageShowModel::eventFilter(QObject *object, QEvent *event)
 
 NodeDataType ImageShowModel::dataType(PortType, PortIndex) const
 {
-    return PixmapData().type();
+    return ImageData().type();
 }
 
 std::shared_ptr<NodeData> ImageShowModel::outData(PortIndex)
@@ -67,19 +65,57 @@ std::shared_ptr<NodeData> ImageShowModel::outData(PortIndex)
     return _nodeData;
 }
 
-void ImageShowModel::setInData(std::shared_ptr<NodeData> nodeData, PortIndex)
+NodeTask ImageShowModel::coSetInData(std::shared_ptr<NodeData> nodeData, PortIndex)
 {
     _nodeData = nodeData;
 
-    if (_nodeData) {
-        auto d = std::dynamic_pointer_cast<PixmapData>(_nodeData);
+    emit dataUpdated(0);
+
+    _tiled = std::dynamic_pointer_cast<TiledImageData>(_nodeData);
+
+    if (_tiled) {
+        loadTiles();
+        co_return;
+    }
 
-        int w = _label->width();
-        int h = _label->height();
-        _label->setPixmap(d->pixmap().scaled(w, h, Qt::KeepAspectRatio));
-    } else {
+    auto d = std::dynamic_pointer_cast<ImageData>(_nodeData);
+
+    if (!d || d->isNull()) {
+        _pyramid.reset();
         _label->setPixmap(QPixmap());
+        co_return;
     }
 
-    emit dataUpdated(0);
+    // 其他显示节点可能已经为同一份数据构建了金字塔，此时立即返回
+    _pyramid = co_await runAsync([d] { return d->pyramid(); });
+
+    updatePreview();
+}
+
+NodeTask ImageShowModel::loadTiles()
+{
+    restart();
+
+    auto tiled = _tiled;
+    int const level = tiled->levelFor(_label->size());
+
+    _tiledLevel = level;
+
+    QImage const image = co_await runAsync([tiled, level] {
+        return tiled->region(level, QRect(QPoint(), tiled->levelSize(level)));
+    });
+
+    // 这一级不比预览大多少，直接构建金字塔
+    _pyramid = std::make_shared<ImagePyramid const>(image);
+
+    updatePreview();
+}
+
+void ImageShowModel::updatePreview()
+{
+    if (!_pyramid)
+        return;
+
+    // 先缩小再转换，QPixmap只需要显示尺寸
+    _label->setPixmap(QPixmap::fromImage(_pyramid->scaled(_label->size())));
 }
@@ -5,12 +5,17 @@
 #include <QObject>
 #include <QLabel>
 
-#include "nodedatamodel.h"
+#include "coroutinenodedatamodel.h"
+#include "imagepyramid.h"
+#include "tiledimagedata.h"
 
 /**
  * @brief 图片显示模型
+ *
+ * 输入图片的金字塔在线程池中构建（同一份数据只构建一次），
+ * 显示与缩放节点时从最近的一级缩放。分块图片只请求覆盖当前预览尺寸的那一级上的块
  */
-class ImageShowModel : public NodeDataModel
+class ImageShowModel : public CoroutineNodeDataModel
 {
     Q_OBJECT
 
@@ -31,16 +36,28 @@ public:
 
     std::shared_ptr<NodeData> outData(PortIndex port) override;
 
-    void setInData(std::shared_ptr<NodeData> nodeData, PortIndex port) override;
-
     QWidget *embeddedWidget() override { return _label; }
 
     bool resizable() const override { return true; }
 
+    bool activeSink() const override { return true; }
+
 protected:
+    NodeTask coSetInData(std::shared_ptr<NodeData> nodeData, PortIndex port) override;
+
     bool eventFilter(QObject *object, QEvent *event) override;
 
+private:
+    void updatePreview();
+
+    //! 在线程池中拼出分块图片上适合当前尺寸的一级
+    NodeTask loadTiles();
+
 private:
     QLabel *_label;
     std::shared_ptr<NodeData> _nodeData;
+    std::shared_ptr<ImagePyramid const> _pyramid;
+
+    std::shared_ptr<TiledImageData> _tiled;
+    int _tiledLevel = 0;
 };
@@ -0,0 +1,311 @@
+#include "mappedimagefile.h"
+
+#include <algorithm>
+#include <cctype>
+#include <limits>
+
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+MappedImageFile::MappedImageFile(QString const &fileName)
+    : _file(fileName)
+{}
+
+MappedImageFile::~MappedImageFile()
+{
+    if (_map)
+        _file.unmap(const_cast<uchar *>(_map));
+}
+
+std::shared_ptr<MappedImageFile> MappedImageFile::open(QString const &fileName, QString *error)
+{
+    std::shared_ptr<MappedImageFile> file(new MappedImageFile(fileName));
+
+    auto fail = [error](QString const &message) {
+        if (error)
+            *error = message;
+
+        return nullptr;
+    };
+
+    if (!file->_file.open(QIODevice::ReadOnly))
+        return fail(file->_file.errorString());
+
+    file->_mapSize = file->_file.size();
+
+    if (file->_mapSize <= 0)
+        return fail(QString("Empty file"));
+
+    file->_map = file->_file.map(0, file->_mapSize);
+
+    if (!file->_map)
+        return fail(file->_file.errorString());
+
+    // a sidecar header wins, a raw dump may well start with "P5"
+    bool const parsed = QFileInfo::exists(fileName + ".json")
+            ? file->parseSidecar(error)
+            : file->parsePnm(error);
+
+    if (!parsed || !file->setLayout(error))
+        return nullptr;
+
+    return file;
+}
+
+bool MappedImageFile::parsePnm(QString *error)
+{
+    auto fail = [error](QString const &message) {
+        if (error)
+            *error = message;
+
+        return false;
+    };
+
+    if (_mapSize < 2 || _map[0] != 'P' || (_map[1] != '5' && _map[1] != '6'))
+        return fail(QString("Not a binary PGM/PPM file and no sidecar header"));
+
+    _channels = _map[1] == '5' ? 1 : 3;
+
+    qint64 pos = 2;
+
+    auto readNumber = [&](int &value) {
+        // whitespace and comments between the header fields
+        while (pos < _mapSize) {
+            if (_map[pos] == '#') {
+                while (pos < _mapSize && _map[pos] != '\n')
+                    ++pos;
+            } else if (std::isspace(_map[pos])) {
+                ++pos;
+            } else {
+                break;
+            }
+        }
+
+        qint64 number = 0;
+        qint64 const begin = pos;
+
+        while (pos < _mapSize && _map[pos] >= '0' && _map[pos] <= '9') {
+            number = number * 10 + (_map[pos++] - '0');
+
+            if (number > std::numeric_limits<int>::max())
+                return false;
+        }
+
+        value = static_cast<int>(number);
+
+        return pos > begin;
+    };
+
+    if (!readNumber(_width) || !readNumber(_height) || !readNumber(_maxValue))
+        return fail(QString("Malformed PGM/PPM header"));
+
+    // exactly one whitespace character ends the header
+    _offset = pos + 1;
+
+    _bytesPerSample = _maxValue > 255 ? 2 : 1;
+    _bigEndian = true;
+    _planar = false;
+
+    return true;
+}
+
+bool MappedImageFile::parseSidecar(QString *error)
+{
+    auto fail = [error](QString const &message) {
+        if (error)
+            *error = message;
+
+        return false;
+    };
+
+    QFile sidecar(_file.fileName() + ".json");
+
+    if (!sidecar.open(QIODevice::ReadOnly))
+        return fail(sidecar.errorString());
+
+    QJsonParseError parseError;
+    QJsonObject const header = QJsonDocument::fromJson(sidecar.readAll(), &parseError).object();
+
+    if (parseError.error != QJsonParseError::NoError)
+        return fail(parseError.errorString());
+
+    int const bitDepth = header["bitDepth"].toInt(8);
+
+    if (bitDepth != 8 && bitDepth != 16)
+        return fail(QString("Unsupported bit depth %1").arg(bitDepth));
+
+    _width = header["width"].toInt();
+    _height = header["height"].toInt();
+    _channels = header["channels"].toInt(1);
+    _bytesPerSample = bitDepth / 8;
+    _maxValue = header["maxValue"].toInt((1 << bitDepth) - 1);
+    _planar = header["planar"].toBool(false);
+    _bigEndian = header["bigEndian"].toBool(false);
+    _offset = static_cast<qint64>(header["offset"].toDouble(0));
+
+    return true;
+}
+
+bool MappedImageFile::setLayout(QString *error)
+{
+    auto fail = [error](QString const &message) {
+        if (error)
+            *error = message;
+
+        return false;
+    };
+
+    if (_width <= 0 || _height <= 0)
+        return fail(QString("Invalid image size"));
+
+    if (_channels != 1 && _channels != 3 && _channels != 4)
+        return fail(QString("Unsupported channel count %1").arg(_channels));
+
+    if (_maxValue <= 0 || _maxValue >= 1 << (8 * _bytesPerSample))
+        return fail(QString("Invalid maximum value %1").arg(_maxValue));
+
+    qint64 const bytes = static_cast<qint64>(_width) * _height * _channels * _bytesPerSample;
+
+    if (_offset < 0 || _offset > _mapSize || bytes > _mapSize - _offset)
+        return fail(QString("File is smaller than the image it describes"));
+
+    _pixels = _map + _offset;
+
+    return true;
+}
+
+int MappedImageFile::sample(int ch, int x, int y) const
+{
+    std::size_t const index = _planar
+            ? (static_cast<std::size_t>(ch) * _height + y) * _width + x
+            : (static_cast<std::size_t>(y) * _width + x) * _channels + ch;
+
+    uchar const *p = _pixels + index * _bytesPerSample;
+
+    int value = p[0];
+    if (_bytesPerSample == 2)
+        value = _bigEndian ? p[0] << 8 | p[1] : p[1] << 8 | p[0];
+
+    value = std::min(value, _maxValue);
+
+    return _maxValue == 255 ? value : (value * 255 + _maxValue / 2) / _maxValue;
+}
+
+QRgb MappedImageFile::pixel(int x, int y) const
+{
+    switch (_channels) {
+    case 1: {
+        int const gray = sample(0, x, y);
+        return qRgb(gray, gray, gray);
+    }
+
+    case 3:
+        return qRgb(sample(0, x, y), sample(1, x, y), sample(2, x, y));
+
+    default:
+        return qPremultiply(qRgba(sample(0, x, y), sample(1, x, y), sample(2, x, y), sample(3, x, y)));
+    }
+}
+
+void MappedImageFile::readRow(int y, int x, int count, QRgb *out) const
+{
+    // 8 bit interleaved samples are converted straight from the mapped row
+    if (_bytesPerSample == 1 && _maxValue == 255 && !_planar) {
+        uchar const *p = _pixels + (static_cast<std::size_t>(y) * _width + x) * _channels;
+
+        switch (_channels) {
+        case 1:
+            for (int i = 0; i < count; ++i)
+                out[i] = 0xff000000u | p[i] * 0x010101u;
+            break;
+
+        case 3:
+            for (int i = 0; i < count; ++i, p += 3)
+                out[i] = qRgb(p[0], p[1], p[2]);
+            break;
+
+        default:
+            for (int i = 0; i < count; ++i, p += 4)
+                out[i] = qPremultiply(qRgba(p[0], p[1], p[2], p[3]));
+            break;
+        }
+
+        return;
+    }
+
+    for (int i = 0; i < count; ++i)
+        out[i] = pixel(x + i, y);
+}
+
+QImage MappedImageFile::region(QRect const &rect) const
+{
+    QRect const bounded = rect & QRect(QPoint(), size());
+
+    QImage result(bounded.size(), QImage::Format_ARGB32_Premultiplied);
+
+    for (int y = 0; y < bounded.height(); ++y)
+        readRow(bounded.top() + y, bounded.left(), bounded.width(), reinterpret_cast<QRgb *>(result.scanLine(y)));
+
+    return result;
+}
+
+QImage MappedImageFile::region(int level, QRect const &rect) const
+{
+    if (level == 0)
+        return region(rect);
+
+    int const scale = 1 << level;
+    QSize const levelSize(std::max(_width >> level, 1), std::max(_height >> level, 1));
+
+    QRect const bounded = rect & QRect(QPoint(), levelSize);
+
+    QImage result(bounded.size(), QImage::Format_ARGB32_Premultiplied);
+
+    auto average = [](QRgb a, QRgb b, QRgb c, QRgb d) {
+        QRgb pixel = 0;
+        for (int shift = 0; shift < 32; shift += 8) {
+            QRgb const sum = (a >> shift & 0xff) + (b >> shift & 0xff) + (c >> shift & 0xff) + (d >> shift & 0xff);
+            pixel |= (sum + 2) / 4 << shift;
+        }
+
+        return pixel;
+    };
+
+    for (int y = 0; y < bounded.height(); ++y) {
+        int const sy0 = std::min((bounded.top() + y) * scale + scale / 2 - 1, _height - 1);
+        int const sy1 = std::min(sy0 + 1, _height - 1);
+
+        QRgb *out = reinterpret_cast<QRgb *>(result.scanLine(y));
+
+        for (int x = 0; x < bounded.width(); ++x) {
+            int const sx0 = std::min((bounded.left() + x) * scale + scale / 2 - 1, _width - 1);
+            int const sx1 = std::min(sx0 + 1, _width - 1);
+
+            out[x] = average(pixel(sx0, sy0), pixel(sx1, sy0), pixel(sx0, sy1), pixel(sx1, sy1));
+        }
+    }
+
+    return result;
+}
+
+QImage MappedImageFile::preview(QSize const &maxSize) const
+{
+    QSize target = size();
+    if (target.width() > maxSize.width() || target.height() > maxSize.height())
+        target = target.scaled(maxSize, Qt::KeepAspectRatio).expandedTo(QSize(1, 1));
+
+    QImage result(target, QImage::Format_ARGB32_Premultiplied);
+
+    for (int y = 0; y < target.height(); ++y) {
+        int const sy = static_cast<int>((2 * static_cast<qint64>(y) + 1) * _height / (2 * target.height()));
+        QRgb *out = reinterpret_cast<QRgb *>(result.scanLine(y));
+
+        for (int x = 0; x < target.width(); ++x) {
+            int const sx = static_cast<int>((2 * static_cast<qint64>(x) + 1) * _width / (2 * target.width()));
+            out[x] = pixel(sx, sy);
+        }
+    }
+
+    return result;
+}
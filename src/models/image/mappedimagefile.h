@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include <QFile>
+#include <QImage>
+#include <QRect>
+#include <QSize>
+#include <QString>
+
+/**
+ * @brief 内存映射的未压缩图片文件
+ *
+ * 支持二进制PGM/PPM（P5/P6，8或16位），以及带JSON头文件（<文件名>.json）的原始数据：
+ * @code
+ * { "width": 4096, "height": 4096, "channels": 3, "bitDepth": 16,
+ *   "planar": true, "offset": 0, "bigEndian": false, "maxValue": 4095 }
+ * @endcode
+ * 除width、height外都可省略（默认单通道8位、交错排列、无偏移、小端、满量程）。
+ *
+ * 打开时只解析文件头并映射文件，像素在读取区域时才由系统按页载入，
+ * 转换也只针对请求的区域。映射只读，所有读取方法都可以在多个线程中同时调用
+ */
+class MappedImageFile
+{
+public:
+    //! 映射fileName，失败时返回空指针并把原因写入error
+    static std::shared_ptr<MappedImageFile> open(QString const &fileName, QString *error = nullptr);
+
+    ~MappedImageFile();
+
+public:
+    QString fileName() const { return _file.fileName(); }
+
+    QSize size() const { return QSize(_width, _height); }
+
+    int channels() const { return _channels; }
+
+    //! rect区域的像素，转换为ARGB32_Premultiplied
+    QImage region(QRect const &rect) const;
+
+    //! 第level级（每级宽高减半，向下取整）上的rect区域：每个像素取对应方块中心2x2个像素的平均，
+    //! 每输出一行只读取文件中的两行
+    QImage region(int level, QRect const &rect) const;
+
+    //! 最近邻采样出不超过maxSize（保持比例）的预览，只访问采样到的行
+    QImage preview(QSize const &maxSize) const;
+
+private:
+    MappedImageFile(QString const &fileName);
+
+    bool parsePnm(QString *error);
+    bool parseSidecar(QString *error);
+
+    //! 校验布局并定位像素
+    bool setLayout(QString *error);
+
+    //! 通道ch在(x, y)处的值，已缩放到[0, 255]
+    int sample(int ch, int x, int y) const;
+
+    QRgb pixel(int x, int y) const;
+
+    void readRow(int y, int x, int count, QRgb *out) const;
+
+private:
+    QFile _file;
+
+    uchar const *_map = nullptr;
+    qint64 _mapSize = 0;
+
+    uchar const *_pixels = nullptr;
+
+    int _width = 0;
+    int _height = 0;
+    int _channels = 1;
+    int _bytesPerSample = 1;
+    int _maxValue = 255;
+    bool _planar = false;
+    bool _bigEndian = false;
+    qint64 _offset = 0;
+};
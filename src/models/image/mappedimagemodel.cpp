@@ -0,0 +1,124 @@
+#include "mappedimagemodel.h"
+#include "imagedata.h"
+
+#include <QDir>
+#include <QEvent>
+#include <QFileDialog>
+
+MappedImageModel::MappedImageModel()
+    : _label(new QLabel("Double click to map a raw image"))
+{
+    _label->setAlignment(Qt::AlignVCenter | Qt::AlignHCenter);
+
+    QFont f = _label->font();
+    f.setBold(true);
+    f.setItalic(true);
+
+    _label->setFont(f);
+    _label->setFixedSize(200, 200);
+    _label->installEventFilter(this);
+}
+
+QJsonObject MappedImageModel::save() const
+{
+    QJsonObject modelJson = NodeDataModel::save();
+
+    if (!_fileName.isEmpty())
+        modelJson["file"] = _fileName;
+
+    return modelJson;
+}
+
+void MappedImageModel::restore(QJsonObject const &modelJson)
+{
+    QString const fileName = modelJson["file"].toString();
+
+    if (!fileName.isEmpty())
+        loadFile(fileName);
+}
+
+unsigned int MappedImageModel::nPorts(PortType portType) const
+{
+    return portType == PortType::Out ? 1 : 0;
+}
+
+NodeDataType MappedImageModel::dataType(PortType, PortIndex) const
+{
+    return ImageData().type();
+}
+
+std::shared_ptr<NodeData> MappedImageModel::outData(PortIndex)
+{
+    return _image;
+}
+
+NodeValidationState MappedImageModel::validationState() const
+{
+    return _error.isEmpty() ? NodeValidationState::Valid : NodeValidationState::Error;
+}
+
+void MappedImageModel::loadFile(QString const &fileName)
+{
+    restart();
+
+    _fileName = fileName;
+    _error.clear();
+    _preview = QPixmap();
+
+    // only the header is read here, the pixels stay in the file
+    _file = MappedImageFile::open(fileName, &_error);
+
+    if (_file) {
+        auto file = _file;
+        // coarse levels are read straight from the file for previews downstream
+        _image = std::make_shared<TiledImageData>(file->size(), [file](int level, QRect const &rect) {
+            return file->region(level, rect);
+        });
+
+        _label->setText(tr("Loading..."));
+        loadPreview();
+    } else {
+        _image.reset();
+        _label->setText(tr("Cannot map file"));
+    }
+
+    emit dataUpdated(0);
+}
+
+NodeTask MappedImageModel::loadPreview()
+{
+    auto file = _file;
+
+    QImage const preview = co_await runAsync([file] {
+        return file->preview(QSize(PreviewExtent, PreviewExtent));
+    });
+
+    _preview = QPixmap::fromImage(preview);
+    _label->setPixmap(_preview.scaled(_label->width(), _label->height(), Qt::KeepAspectRatio));
+}
+
+bool MappedImageModel::eventFilter(QObject *object, QEvent *event)
+{
+    if (object == _label) {
+        if (event->type() == QEvent::MouseButtonPress) {
+            auto dialog = new QFileDialog(nullptr,
+                                          tr("Map Raw Image"),
+                                          QDir::homePath(),
+                                          tr("Raw Images (*.pgm *.ppm *.pnm *.raw *.bin);;All Files (*)"));
+            dialog->setAttribute(Qt::WA_DeleteOnClose);
+            dialog->setFileMode(QFileDialog::ExistingFile);
+
+            connect(dialog, &QFileDialog::fileSelected,
+                    this, [this](QString const &fileName) { loadFile(fileName); });
+
+            dialog->open();
+
+            return true;
+        } else if (event->type() == QEvent::Resize) {
+            if (!_preview.isNull())
+                _label->setPixmap(_preview.scaled(_label->width(), _label->height(), Qt::KeepAspectRatio));
+        }
+    }
+
+    return false;
+}
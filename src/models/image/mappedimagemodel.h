@@ -0,0 +1,72 @@
+#pragma once
+
+#include <memory>
+
+#include <QLabel>
+#include <QPixmap>
+
+#include "nodedata.h"
+#include "coroutinenodedatamodel.h"
+#include "mappedimagefile.h"
+#include "tiledimagedata.h"
+
+/**
+ * @brief 内存映射的原始图片源
+ *
+ * 用于PGM/PPM及带头文件的原始数据等超大的未压缩图片：文件只被映射而不读入，
+ * 输出为TiledImageData，下游请求哪些块才转换文件中对应的区域，
+ * 未被访问的部分不占用内存
+ */
+class MappedImageModel : public CoroutineNodeDataModel
+{
+    Q_OBJECT
+
+public:
+    MappedImageModel();
+
+public:
+    QJsonObject save() const override;
+    void restore(QJsonObject const &modelJson) override;
+
+public:
+    QString caption() const override { return QString("Mapped Image Source"); }
+    QString name() const override { return QString("MappedImageModel"); }
+
+public:
+    unsigned int nPorts(PortType portType) const override;
+
+    NodeDataType dataType(PortType portType, PortIndex portIndex) const override;
+
+    std::shared_ptr<NodeData> outData(PortIndex port) override;
+
+    QWidget *embeddedWidget() override { return _label; }
+
+    bool resizable() const override { return true; }
+
+    NodeValidationState validationState() const override;
+    QString validationMessage() const override { return _error; }
+
+public:
+    QString fileName() const { return _fileName; }
+
+    //! 映射文件并更新输出，预览在线程池中生成
+    void loadFile(QString const &fileName);
+
+protected:
+    bool eventFilter(QObject *object, QEvent *event) override;
+
+private:
+    //! 在线程池中采样预览
+    NodeTask loadPreview();
+
+private:
+    static constexpr int PreviewExtent = 512;
+
+    QLabel *_label;
+    QString _fileName;
+    QString _error;
+
+    std::shared_ptr<MappedImageFile> _file;
+    std::shared_ptr<TiledImageData> _image;
+    QPixmap _preview;
+};
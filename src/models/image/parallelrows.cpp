@@ -0,0 +1,81 @@
+#include "parallelrows.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+#include <QMutex>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include "computetask.h"
+
+namespace {
+
+struct ParallelState
+{
+    int rows;
+    int chunkRows;
+    int chunks;
+
+    // only called for chunks taken before all of them were done
+    std::function<void(int, int)> const *function;
+
+    std::atomic<int> next { 0 };
+    std::atomic<int> done { 0 };
+
+    QMutex mutex;
+    QWaitCondition finished;
+};
+
+void runChunks(ParallelState &state)
+{
+    int processed = 0;
+
+    for (int chunk = state.next++; chunk < state.chunks; chunk = state.next++) {
+        int const begin = chunk * state.chunkRows;
+        (*state.function)(begin, std::min(begin + state.chunkRows, state.rows));
+
+        ++processed;
+    }
+
+    if (processed > 0 && state.done.fetch_add(processed) + processed == state.chunks) {
+        QMutexLocker locker(&state.mutex);
+        state.finished.wakeAll();
+    }
+}
+
+} // namespace
+
+void parallelRows(int rows, std::function<void(int, int)> const &function, int minChunkRows)
+{
+    QThreadPool *pool = QThreadPool::globalInstance();
+
+    int const threads = std::max(pool->maxThreadCount(), 1);
+
+    // a few chunks per thread even out rows of uneven cost
+    int const chunks = std::min(rows / std::max(minChunkRows, 1), threads * 4);
+
+    if (chunks <= 1) {
+        if (rows > 0)
+            function(0, rows);
+        return;
+    }
+
+    auto state = std::make_shared<ParallelState>();
+    state->rows = rows;
+    state->chunkRows = (rows + chunks - 1) / chunks;
+    state->chunks = (rows + state->chunkRows - 1) / state->chunkRows;
+    state->function = &function;
+
+    // helpers that start after the work is done return at once
+    int const helpers = std::min(threads, state->chunks) - 1;
+    for (int i = 0; i < helpers; ++i)
+        pool->start(new ComputeTask([state] { runChunks(*state); }));
+
+    runChunks(*state);
+
+    QMutexLocker locker(&state->mutex);
+    while (state->done.load() < state->chunks)
+        state->finished.wait(&state->mutex);
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <functional>
+
+//! 把[0, rows)分成不少于minChunkRows行的若干块，在全局线程池与调用线程中并行执行
+//! function(rowBegin, rowEnd)，返回时所有块都已完成。调用线程也参与计算，
+//! 因此在线程池的线程中（包括嵌套）调用也不会死锁
+void parallelRows(int rows,
+                  std::function<void(int rowBegin, int rowEnd)> const &function,
+                  int minChunkRows = 16);
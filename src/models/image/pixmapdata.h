@@ -3,6 +3,7 @@
 #include <QPixmap>
 
 #include "nodedata.h"
+#include "imagedata.h"
 
 /**
  * @brief 可能包含需要在节点编辑器图形中传输的任何用户数据
@@ -20,6 +21,22 @@ public:
     }
     QPixmap pixmap() const { return _pixmap; }
 
+    //! 第一次调用时取回像素计算，之后直接返回；只能在GUI线程中调用
+    std::size_t hash() const override
+    {
+        if (_hash == 0)
+            _hash = imageContentHash(_pixmap.toImage(), 1);
+
+        return _hash;
+    }
+
+    std::size_t byteSize() const override
+    {
+        return static_cast<std::size_t>(_pixmap.width()) * _pixmap.height() * _pixmap.depth() / 8;
+    }
+
 private:
     QPixmap _pixmap;
+
+    mutable std::size_t _hash = 0;
 };
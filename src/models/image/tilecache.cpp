@@ -0,0 +1,145 @@
+#include "tilecache.h"
+
+#include <utility>
+
+#include <QHash>
+
+namespace {
+
+// bookkeeping cost of an entry beyond the pixels it holds
+constexpr std::size_t EntryOverhead = 128;
+
+}
+
+TileCache &TileCache::instance()
+{
+    static TileCache cache;
+    return cache;
+}
+
+TileCache::TileCache()
+    : _byteBudget(512 * 1024 * 1024),
+      _byteSize(0),
+      _hits(0),
+      _misses(0)
+{}
+
+bool TileCache::find(Key const &key, QImage &tile)
+{
+    QMutexLocker locker(&_mutex);
+
+    auto it = _index.find(key);
+
+    if (it == _index.end()) {
+        ++_misses;
+        return false;
+    }
+
+    ++_hits;
+
+    _entries.splice(_entries.begin(), _entries, it->second);
+    tile = it->second->tile;
+
+    return true;
+}
+
+void TileCache::insert(Key const &key, QImage tile)
+{
+    std::size_t const bytes = EntryOverhead + static_cast<std::size_t>(tile.sizeInBytes());
+
+    QMutexLocker locker(&_mutex);
+
+    // another thread may have computed the same tile meanwhile
+    auto it = _index.find(key);
+    if (it != _index.end()) {
+        _byteSize -= it->second->bytes;
+        _entries.erase(it->second);
+        _index.erase(it);
+    }
+
+    if (bytes > _byteBudget)
+        return;
+
+    _entries.push_front({ key, std::move(tile), bytes });
+    _index.emplace(key, _entries.begin());
+    _byteSize += bytes;
+
+    evict();
+}
+
+void TileCache::removeImage(quint64 image)
+{
+    QMutexLocker locker(&_mutex);
+
+    for (auto it = _entries.begin(); it != _entries.end();) {
+        if (it->key.image == image) {
+            _byteSize -= it->bytes;
+            _index.erase(it->key);
+            it = _entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void TileCache::clear()
+{
+    QMutexLocker locker(&_mutex);
+
+    _index.clear();
+    _entries.clear();
+    _byteSize = 0;
+}
+
+std::size_t TileCache::byteBudget() const
+{
+    QMutexLocker locker(&_mutex);
+    return _byteBudget;
+}
+
+void TileCache::setByteBudget(std::size_t bytes)
+{
+    QMutexLocker locker(&_mutex);
+
+    _byteBudget = bytes;
+    evict();
+}
+
+std::size_t TileCache::byteSize() const
+{
+    QMutexLocker locker(&_mutex);
+    return _byteSize;
+}
+
+std::size_t TileCache::hits() const
+{
+    QMutexLocker locker(&_mutex);
+    return _hits;
+}
+
+std::size_t TileCache::misses() const
+{
+    QMutexLocker locker(&_mutex);
+    return _misses;
+}
+
+std::size_t TileCache::KeyHash::operator()(Key const &key) const
+{
+    std::size_t seed = qHash(key.image);
+
+    for (int value : { key.level, key.column, key.row })
+        seed ^= static_cast<std::size_t>(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+
+    return seed;
+}
+
+void TileCache::evict()
+{
+    while (_byteSize > _byteBudget && !_entries.empty()) {
+        Entry const &entry = _entries.back();
+
+        _byteSize -= entry.bytes;
+        _index.erase(entry.key);
+        _entries.pop_back();
+    }
+}
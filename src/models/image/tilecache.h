@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+
+#include <QImage>
+#include <QMutex>
+
+/**
+ * @brief 分块图片（TiledImageData）的块缓存，所有图片共享一个字节预算，按LRU淘汰
+ *
+ * 线程安全：块在工作线程中计算并存入
+ */
+class TileCache
+{
+public:
+    struct Key
+    {
+        quint64 image;
+        int level;
+        int column;
+        int row;
+
+        friend bool operator==(Key const &k1, Key const &k2)
+        {
+            return k1.image == k2.image && k1.level == k2.level &&
+                   k1.column == k2.column && k1.row == k2.row;
+        }
+    };
+
+public:
+    static TileCache &instance();
+
+    TileCache();
+
+    //! 命中时写入tile并返回true
+    bool find(Key const &key, QImage &tile);
+    void insert(Key const &key, QImage tile);
+
+    //! 删除一张图片的所有块（图片被销毁时）
+    void removeImage(quint64 image);
+
+    void clear();
+
+    std::size_t byteBudget() const;
+    void setByteBudget(std::size_t bytes);
+
+    std::size_t byteSize() const;
+
+    std::size_t hits() const;
+    std::size_t misses() const;
+
+private:
+    struct KeyHash
+    {
+        std::size_t operator()(Key const &key) const;
+    };
+
+    struct Entry
+    {
+        Key key;
+        QImage tile;
+        std::size_t bytes;
+    };
+
+    using EntryList = std::list<Entry>;
+
+    void evict();
+
+private:
+    mutable QMutex _mutex;
+
+    // most recently used first
+    EntryList _entries;
+    std::unordered_map<Key, EntryList::iterator, KeyHash> _index;
+
+    std::size_t _byteBudget;
+    std::size_t _byteSize;
+
+    std::size_t _hits;
+    std::size_t _misses;
+};
@@ -0,0 +1,206 @@
+#include "tiledimagedata.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+#include <QHash>
+
+#include "imagedata.h"
+#include "parallelrows.h"
+#include "tilecache.h"
+
+static quint64 nextImageId()
+{
+    static std::atomic<quint64> id { 0 };
+    return ++id;
+}
+
+TiledImageData::TiledImageData(QSize const &size, RegionFunction function)
+    : _id(nextImageId()),
+      _size(size),
+      _function([function = std::move(function)](int level, QRect const &rect) {
+          return level == 0 ? function(rect) : QImage();
+      })
+{}
+
+TiledImageData::TiledImageData(QSize const &size, LevelFunction function)
+    : _id(nextImageId()),
+      _size(size),
+      _function(std::move(function))
+{}
+
+TiledImageData::~TiledImageData()
+{
+    TileCache::instance().removeImage(_id);
+}
+
+std::shared_ptr<TiledImageData> TiledImageData::fromImage(QImage const &image)
+{
+    QImage const source = image.format() == QImage::Format_ARGB32_Premultiplied
+            ? image
+            : image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+    return std::make_shared<TiledImageData>(source.size(), [source](QRect const &rect) {
+        return source.copy(rect);
+    });
+}
+
+std::shared_ptr<TiledImageData> TiledImageData::fromImageData(std::shared_ptr<ImageData const> data)
+{
+    QSize const size = data->image().size();
+
+    return std::make_shared<TiledImageData>(size, [data](int level, QRect const &rect) {
+        if (level == 0)
+            return data->image().copy(rect);
+
+        // the levels the pyramid lacks are scaled down from the tiles
+        std::shared_ptr<ImagePyramid const> const pyramid = data->pyramid();
+        return level < pyramid->levelCount() ? pyramid->level(level).copy(rect) : QImage();
+    });
+}
+
+NodeDataType TiledImageData::type() const
+{
+    return ImageData().type();
+}
+
+std::size_t TiledImageData::hash() const
+{
+    return qHash(_id, 3);
+}
+
+QSize TiledImageData::size() const
+{
+    return _size;
+}
+
+int TiledImageData::levelCount() const
+{
+    int levels = 1;
+
+    // down to the level which fits in a single tile
+    QSize size = _size;
+    while (size.width() > TileSize || size.height() > TileSize) {
+        size = QSize(std::max(size.width() / 2, 1), std::max(size.height() / 2, 1));
+        ++levels;
+    }
+
+    return levels;
+}
+
+QSize TiledImageData::levelSize(int level) const
+{
+    return QSize(std::max(_size.width() >> level, 1), std::max(_size.height() >> level, 1));
+}
+
+int TiledImageData::levelFor(QSize const &size) const
+{
+    QSize const target = _size.scaled(size, Qt::KeepAspectRatio);
+
+    int level = 0;
+    while (level + 1 < levelCount() &&
+           levelSize(level + 1).width() >= target.width() &&
+           levelSize(level + 1).height() >= target.height())
+        ++level;
+
+    return level;
+}
+
+QImage TiledImageData::tile(int level, int column, int row) const
+{
+    TileCache::Key const key { _id, level, column, row };
+
+    QImage result;
+    if (TileCache::instance().find(key, result))
+        return result;
+
+    QRect const rect = QRect(column * TileSize, row * TileSize, TileSize, TileSize)
+            & QRect(QPoint(), levelSize(level));
+
+    result = computeTile(level, rect);
+
+    TileCache::instance().insert(key, result);
+
+    return result;
+}
+
+QImage TiledImageData::computeTile(int level, QRect const &rect) const
+{
+    QImage const pixels = _function(level, rect);
+
+    if (level == 0 || !pixels.isNull()) {
+        if (pixels.format() == QImage::Format_ARGB32_Premultiplied)
+            return pixels;
+
+        return pixels.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    }
+
+    // the tiles of the finer level are cached as well, the next coarser
+    // level is computed from them without going back to level 0
+    QRect const parent = QRect(rect.topLeft() * 2, rect.size() * 2)
+            & QRect(QPoint(), levelSize(level - 1));
+
+    return region(level - 1, parent).scaled(rect.size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+}
+
+QImage TiledImageData::region(int level, QRect const &rect) const
+{
+    QRect const bounded = rect & QRect(QPoint(), levelSize(level));
+
+    if (bounded.isEmpty())
+        return QImage();
+
+    int const firstColumn = bounded.left() / TileSize;
+    int const firstRow    = bounded.top() / TileSize;
+    int const columns     = bounded.right() / TileSize - firstColumn + 1;
+    int const rows        = bounded.bottom() / TileSize - firstRow + 1;
+
+    // a single tile needn't be copied
+    if (columns == 1 && rows == 1) {
+        QImage const t = tile(level, firstColumn, firstRow);
+        QRect const tileRect(firstColumn * TileSize, firstRow * TileSize, t.width(), t.height());
+
+        return bounded == tileRect ? t : t.copy(bounded.translated(-tileRect.topLeft()));
+    }
+
+    QImage result(bounded.size(), QImage::Format_ARGB32_Premultiplied);
+
+    uchar *bits = result.bits();
+    qsizetype const stride = result.bytesPerLine();
+
+    // each tile writes its own part of the result
+    parallelRows(columns * rows, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            int const column = firstColumn + i % columns;
+            int const row    = firstRow + i / columns;
+
+            QImage const t = tile(level, column, row);
+
+            QRect const tileRect(column * TileSize, row * TileSize, t.width(), t.height());
+            QRect const part = tileRect & bounded;
+
+            for (int y = part.top(); y <= part.bottom(); ++y) {
+                std::memcpy(bits + (y - bounded.top()) * stride + (part.left() - bounded.left()) * 4,
+                            t.constScanLine(y - tileRect.top()) + (part.left() - tileRect.left()) * 4,
+                            static_cast<std::size_t>(part.width()) * 4);
+            }
+        }
+    }, 1);
+
+    return result;
+}
+
+QImage imageFromData(std::shared_ptr<NodeData> const &data, QSize const &maxSize)
+{
+    if (auto imageData = std::dynamic_pointer_cast<ImageData>(data))
+        return imageData->image();
+
+    if (auto tiled = std::dynamic_pointer_cast<TiledImageData>(data)) {
+        int const level = maxSize.isValid() ? tiled->levelFor(maxSize) : 0;
+        return tiled->region(level, QRect(QPoint(), tiled->levelSize(level)));
+    }
+
+    return QImage();
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+
+#include <QImage>
+#include <QRect>
+#include <QSize>
+
+#include "nodedata.h"
+
+class ImageData;
+
+/**
+ * @brief 按块按需计算的大图
+ *
+ * 图片不整体保存在内存中：使用者请求某个区域时，才计算覆盖它的块（TileSize见方），
+ * 块存入共享的TileCache，超出字节预算时按LRU淘汰，之后再请求时重新计算。
+ * 第0级为原始分辨率，之后每级宽高减半（向下取整，与ImagePyramid相同）。
+ * 较粗一级的块由计算函数直接给出，或由上一级的块缩小得到，
+ * 预览只需请求较粗一级上的块，上游也只按这一级的分辨率计算。
+ *
+ * 与ImageData使用同一数据类型，端口可以接收两者之一；所有方法都是线程安全的
+ */
+class TiledImageData : public NodeData
+{
+public:
+    static constexpr int TileSize = 256;
+
+    //! 计算第0级上rect区域的像素，返回ARGB32_Premultiplied格式、rect尺寸的图片。
+    //! 在工作线程中并发调用，只能按值捕获
+    using RegionFunction = std::function<QImage(QRect const &rect)>;
+
+    //! 计算第level级上rect区域的像素。返回空图片时该级由上一级缩小得到（第0级除外）
+    using LevelFunction = std::function<QImage(int level, QRect const &rect)>;
+
+public:
+    TiledImageData(QSize const &size, RegionFunction function);
+    TiledImageData(QSize const &size, LevelFunction function);
+    ~TiledImageData() override;
+
+    //! 以整张图片提供像素
+    static std::shared_ptr<TiledImageData> fromImage(QImage const &image);
+
+    //! 以ImageData提供像素，较粗的级别取自其金字塔（与其他使用者共享）
+    static std::shared_ptr<TiledImageData> fromImageData(std::shared_ptr<ImageData const> data);
+
+public:
+    NodeDataType type() const override;
+
+    //! 按对象区分：内容相同的两张分块图片哈希不同
+    std::size_t hash() const override;
+
+    QSize size() const;
+
+    int levelCount() const;
+    QSize levelSize(int level) const;
+
+    //! 缩放到size以内（保持比例）时，仍不小于缩放结果的最粗一级
+    int levelFor(QSize const &size) const;
+
+    //! 第level级上(column, row)处的块，边缘的块可能小于TileSize
+    QImage tile(int level, int column, int row) const;
+
+    //! 拼出第level级上的rect区域，所需的块并行计算
+    QImage region(int level, QRect const &rect) const;
+
+private:
+    QImage computeTile(int level, QRect const &rect) const;
+
+private:
+    quint64 _id;
+    QSize _size;
+    LevelFunction _function;
+};
+
+//! 取出ImageData或TiledImageData中的图片：分块图片按不小于maxSize的最粗一级拼出，
+//! maxSize无效时拼出原始分辨率。其他数据返回空图片
+QImage imageFromData(std::shared_ptr<NodeData> const &data, QSize const &maxSize = QSize());
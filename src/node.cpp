@@ -1,27 +1,44 @@
 #include "node.h"
 
 #include <QObject>
+#include <QJsonDocument>
+#include <QMutex>
+#include <QThreadPool>
+#include <algorithm>
+#include <tuple>
 #include <utility>
 #include <iostream>
 
-#include "flowscene.h"
+#include "flowgraph.h"
 #include "nodegraphicsobject.h"
 #include "nodedatamodel.h"
 #include "connectiongraphicsobject.h"
 #include "connectionstate.h"
+#include "computetask.h"
 
-Node::Node(std::unique_ptr<NodeDataModel> &&dataModel)
-    : m_uuid_(QUuid::createUuid()),
-      m_node_data_model_(std::move(dataModel)),
-      m_node_state_(m_node_data_model_),
-      m_node_geometry_(m_node_data_model_),
-      m_node_graphics_object_(nullptr)
+//! 节点与工作线程共享的状态。任务在计算期间持有mutex，
+//! 节点析构时借此等待正在运行的任务，并取消尚未开始的任务
+struct Node::ComputeState
+{
+    QMutex mutex;
+    bool cancelled = false;
+};
+
+Node::Node(std::unique_ptr<NodeDataModel> &&dataModel, FlowGraph &graph)
+    : m_node_data_model_(std::move(dataModel)),
+      m_node_graphics_object_(nullptr),
+      m_flow_graph_(graph),
+      m_cache_key_valid_(false),
+      m_compute_state_(std::make_shared<ComputeState>()),
+      m_computing_(false),
+      m_generation_(0),
+      m_job_generation_(0),
+      m_uuid_(QUuid::createUuid()),
+      m_node_state_(m_node_data_model_)
 {
-    m_node_geometry_.recalculateSize();
-
     // propagate data: model => node
     connect(m_node_data_model_.get(), &NodeDataModel::dataUpdated,
-            this, &Node::onDataUpdated);
+            this, &Node::onModelDataUpdated);
 
     connect(m_node_data_model_.get(), &NodeDataModel::dataInvalidated,
             this, &Node::onDataInvalidated);
@@ -30,7 +47,13 @@ Node::Node(std::unique_ptr<NodeDataModel> &&dataModel)
             this, &Node::onNodeSizeUpdated );
 }
 
-Node::~Node() = default;
+Node::~Node()
+{
+    m_node_data_model_->cancellationToken().cancel();
+
+    QMutexLocker locker(&m_compute_state_->mutex);
+    m_compute_state_->cancelled = true;
+}
 
 QJsonObject Node::save() const
 {
@@ -38,9 +61,11 @@ QJsonObject Node::save() const
     nodeJson["id"] = m_uuid_.toString();
     nodeJson["model"] = m_node_data_model_->save();
 
+    QPointF const position = m_node_graphics_object_ ? m_node_graphics_object_->pos() : m_position_;
+
     QJsonObject obj;
-    obj["x"] = m_node_graphics_object_->pos().x();
-    obj["y"] = m_node_graphics_object_->pos().y();
+    obj["x"] = position.x();
+    obj["y"] = position.y();
     nodeJson["position"] = obj;
 
     return nodeJson;
@@ -51,9 +76,11 @@ void Node::restore(QJsonObject const &json)
     m_uuid_ = QUuid(json["id"].toString());
 
     QJsonObject positionJson = json["position"].toObject();
-    QPointF     point(positionJson["x"].toDouble(),
-            positionJson["y"].toDouble());
-    m_node_graphics_object_->setPos(point);
+    m_position_ = QPointF(positionJson["x"].toDouble(),
+                          positionJson["y"].toDouble());
+
+    if (m_node_graphics_object_)
+        m_node_graphics_object_->setPos(m_position_);
 
     m_node_data_model_->restore(json["model"].toObject());
 }
@@ -70,7 +97,7 @@ void Node::reactToPossibleConnection(PortType reactingPortType,
     QTransform const t = m_node_graphics_object_->sceneTransform();
     QPointF p = t.inverted().map(scenePoint);
 
-    m_node_geometry_.setDraggingPosition(p);
+    nodeGeometry().setDraggingPosition(p);
     m_node_graphics_object_->update();
     m_node_state_.setReaction(NodeState::REACTING,
                            reactingPortType,
@@ -83,6 +110,11 @@ void Node::resetReactionToConnection()
     m_node_graphics_object_->update();
 }
 
+bool Node::hasGraphicsObject() const
+{
+    return m_node_graphics_object_ != nullptr;
+}
+
 NodeGraphicsObject const &Node::nodeGraphicsObject() const
 {
     return *m_node_graphics_object_.get();
@@ -96,18 +128,26 @@ NodeGraphicsObject &Node::nodeGraphicsObject()
 void Node::setGraphicsObject(std::unique_ptr<NodeGraphicsObject>&& graphics)
 {
     m_node_graphics_object_ = std::move(graphics);
-    m_node_geometry_.recalculateSize();
+    m_node_graphics_object_->setPos(m_position_);
+
+    nodeGeometry().recalculateSize();
 }
 
 NodeGeometry &Node::nodeGeometry()
 {
-    return m_node_geometry_;
+    if (!m_node_geometry_)
+        m_node_geometry_ = std::make_unique<NodeGeometry>(m_node_data_model_);
+
+    return *m_node_geometry_;
 }
 
 
 NodeGeometry const &Node::nodeGeometry() const
 {
-    return m_node_geometry_;
+    if (!m_node_geometry_)
+        m_node_geometry_ = std::make_unique<NodeGeometry>(m_node_data_model_);
+
+    return *m_node_geometry_;
 }
 
 NodeState const &Node::nodeState() const
@@ -125,24 +165,83 @@ NodeDataModel *Node::nodeDataModel() const
     return m_node_data_model_.get();
 }
 
+quint64 Node::generation() const
+{
+    return m_generation_;
+}
+
+std::shared_ptr<NodeData> Node::outData(PortIndex index) const
+{
+    if (!m_cached_outputs_.empty())
+        return m_cached_outputs_[index];
+
+    return m_node_data_model_->outData(index);
+}
+
+void Node::inputDelivered(std::shared_ptr<NodeData> nodeData,
+                          PortIndex inPortIndex,
+                          const QUuid &connectionId)
+{
+    Input &input = recordInput(inPortIndex, connectionId);
+    input.data  = std::move(nodeData);
+    input.stale = false;
+
+    m_cached_outputs_.clear();
+    eraseDeliveredEmptyInputs();
+}
+
 void Node::propagateData(std::shared_ptr<NodeData> nodeData,
                          PortIndex inPortIndex,
-                         const QUuid &connectionId) const
+                         const QUuid &connectionId)
 {
-    m_node_data_model_->setInData(std::move(nodeData), inPortIndex, connectionId);
+    if (m_flow_graph_.deferPropagation(*this, nodeData, inPortIndex, connectionId))
+        return;
 
-    // Recalculate the nodes visuals. A data change can result in the
-    // node taking more space than before, so this forces a
-    // recalculate+repaint on the affected node.
-    m_node_graphics_object_->setGeometryChanged();
-    m_node_geometry_.recalculateSize();
-    m_node_graphics_object_->update();
-    m_node_graphics_object_->moveConnections();
+    deliverData(std::move(nodeData), inPortIndex, connectionId);
+}
+
+void Node::deliverData(std::shared_ptr<NodeData> nodeData,
+                       PortIndex inPortIndex,
+                       const QUuid &connectionId)
+{
+    Input &input = recordInput(inPortIndex, connectionId);
+    input.data  = std::move(nodeData);
+    input.stale = true;
+
+    ++m_generation_;
+
+    // The running job is obsolete now: let it stop early, its result
+    // is discarded and the new input is sent when it finishes.
+    if (m_computing_) {
+        m_node_data_model_->cancellationToken().cancel();
+        return;
+    }
+
+    if (serveFromCache())
+        return;
+
+    if (m_node_data_model_->asyncCompute())
+        scheduleCompute();
+    else
+        computeStaleInputs();
 }
 
 void Node::onDataUpdated(PortIndex index)
 {
-    auto nodeData = m_node_data_model_->outData(index);
+    // propagated once the running job has finished
+    if (m_computing_) {
+        if (std::find(m_updated_ports_.begin(), m_updated_ports_.end(), index) == m_updated_ports_.end())
+            m_updated_ports_.push_back(index);
+
+        return;
+    }
+
+    if (m_flow_graph_.propagationMode() != FlowGraph::PropagationMode::Eager) {
+        m_flow_graph_.markDirty(*this, index);
+        return;
+    }
+
+    auto nodeData = outData(index);
 
     auto const &connections =
             m_node_state_.connections(PortType::Out, index);
@@ -162,6 +261,9 @@ void Node::onDataInvalidated(PortIndex index)
 
 void Node::onNodeSizeUpdated()
 {
+    if (!m_node_graphics_object_)
+        return;
+
     if(nodeDataModel()->embeddedWidget()) {
         nodeDataModel()->embeddedWidget()->adjustSize();
     }
@@ -170,8 +272,228 @@ void Node::onNodeSizeUpdated()
         for (auto &conn_set : nodeState().getEntries(type)) {
             for (auto &pair: conn_set) {
                 Connection* conn = pair.second;
-                conn->getConnectionGraphicsObject().move();
+                if (conn->hasGraphicsObject())
+                    conn->getConnectionGraphicsObject().move();
             }
         }
     }
 }
+
+void Node::onModelDataUpdated(PortIndex index)
+{
+    if (!m_computing_ && !m_cached_outputs_.empty()) {
+        // The model changed on its own (e.g. a parameter was edited) while
+        // its outputs were served from the cache. Bring it up to date with
+        // the inputs first, that computation publishes the outputs.
+        m_cached_outputs_.clear();
+
+        if (hasStaleInputs()) {
+            if (m_node_data_model_->asyncCompute())
+                scheduleCompute();
+            else
+                computeStaleInputs();
+
+            return;
+        }
+    }
+
+    onDataUpdated(index);
+}
+
+void Node::onComputeFinished()
+{
+    m_computing_ = false;
+
+    emit m_node_data_model_->computingFinished();
+
+    std::vector<PortIndex> updatedPorts;
+    updatedPorts.swap(m_updated_ports_);
+
+    eraseDeliveredEmptyInputs();
+
+    if (m_job_generation_ != m_generation_) {
+        // superseded, possibly cancelled half way: neither cache nor propagate it
+        m_cache_key_valid_ = false;
+        updatedPorts.clear();
+    } else {
+        storeInCache();
+    }
+
+    recalculateVisuals();
+
+    for (PortIndex index : updatedPorts)
+        onDataUpdated(index);
+
+    if (hasStaleInputs() && !serveFromCache())
+        scheduleCompute();
+}
+
+void Node::recalculateVisuals()
+{
+    // Recalculate the nodes visuals. A data change can result in the
+    // node taking more space than before, so this forces a
+    // recalculate+repaint on the affected node.
+    if (!m_node_graphics_object_)
+        return;
+
+    m_node_graphics_object_->setGeometryChanged();
+    nodeGeometry().recalculateSize();
+    m_node_graphics_object_->update();
+    m_node_graphics_object_->moveConnections();
+}
+
+Node::Input &Node::recordInput(PortIndex port, QUuid const &connectionId)
+{
+    auto it = std::find_if(m_inputs_.begin(), m_inputs_.end(),
+                           [&](Input const &input)
+    {
+        return input.port == port && input.connectionId == connectionId;
+    });
+
+    if (it != m_inputs_.end())
+        return *it;
+
+    m_inputs_.push_back({ port, connectionId, nullptr, false });
+    return m_inputs_.back();
+}
+
+bool Node::hasStaleInputs() const
+{
+    return std::any_of(m_inputs_.begin(), m_inputs_.end(),
+                       [](Input const &input) { return input.stale; });
+}
+
+void Node::computeStaleInputs()
+{
+    m_cached_outputs_.clear();
+
+    // setInData pushes data downstream synchronously, don't hold iterators
+    for (std::size_t i = 0; i < m_inputs_.size(); ++i) {
+        if (!m_inputs_[i].stale)
+            continue;
+
+        m_inputs_[i].stale = false;
+
+        Input const input = m_inputs_[i];
+        m_node_data_model_->setInData(input.data, input.port, input.connectionId);
+    }
+
+    eraseDeliveredEmptyInputs();
+    storeInCache();
+    recalculateVisuals();
+}
+
+void Node::scheduleCompute()
+{
+    if (m_computing_ || !hasStaleInputs())
+        return;
+
+    std::vector<Input> inputs;
+    for (auto &input : m_inputs_) {
+        if (input.stale) {
+            inputs.push_back(input);
+            input.stale = false;
+        }
+    }
+
+    m_cached_outputs_.clear();
+    m_computing_ = true;
+    m_job_generation_ = m_generation_;
+
+    m_node_data_model_->setCancellationToken(CancellationToken());
+
+    emit m_node_data_model_->computingStarted();
+
+    auto state = m_compute_state_;
+    auto model = m_node_data_model_.get();
+
+    // dataUpdated emitted by the model on the worker is queued to this node,
+    // arrives before onComputeFinished and is held back until then
+    m_flow_graph_.threadPool().start(new ComputeTask([this, state, model, inputs]()
+    {
+        QMutexLocker locker(&state->mutex);
+        if (state->cancelled)
+            return;
+
+        for (auto const &input : inputs)
+            model->setInData(input.data, input.port, input.connectionId);
+
+        QMetaObject::invokeMethod(this, &Node::onComputeFinished, Qt::QueuedConnection);
+    }));
+}
+
+bool Node::serveFromCache()
+{
+    m_cache_key_valid_ = false;
+
+    if (!m_node_data_model_->memoizable())
+        return false;
+
+    NodeOutputCache::Key &key = m_cache_key_;
+    key.parameters = QJsonDocument(m_node_data_model_->save()).toJson(QJsonDocument::Compact);
+    key.inputs.clear();
+
+    std::vector<Input const *> inputs;
+    for (auto const &input : m_inputs_) {
+        // an empty input is the same as no input for the model
+        if (input.data)
+            inputs.push_back(&input);
+    }
+
+    std::sort(inputs.begin(), inputs.end(),
+              [](Input const *i1, Input const *i2)
+    {
+        return std::tie(i1->port, i1->connectionId) < std::tie(i2->port, i2->connectionId);
+    });
+
+    for (Input const *input : inputs) {
+        std::size_t const hash = input->data->hash();
+        if (hash == 0)
+            return false;
+
+        key.inputs.push_back(static_cast<std::size_t>(input->port));
+        key.inputs.push_back(hash);
+    }
+
+    m_cache_key_valid_ = true;
+
+    NodeOutputCache::Outputs outputs;
+    if (!m_flow_graph_.outputCache().find(key, outputs))
+        return false;
+
+    m_cached_outputs_ = std::move(outputs);
+
+    for (std::size_t i = 0; i < m_cached_outputs_.size(); ++i)
+        onDataUpdated(static_cast<PortIndex>(i));
+
+    return true;
+}
+
+void Node::storeInCache()
+{
+    if (!m_cache_key_valid_)
+        return;
+
+    m_cache_key_valid_ = false;
+
+    // the parameters may have been edited while computing
+    if (QJsonDocument(m_node_data_model_->save()).toJson(QJsonDocument::Compact) != m_cache_key_.parameters)
+        return;
+
+    NodeOutputCache::Outputs outputs;
+
+    unsigned int const nOutPorts = m_node_data_model_->nPorts(PortType::Out);
+    for (unsigned int i = 0; i < nOutPorts; ++i)
+        outputs.push_back(m_node_data_model_->outData(static_cast<PortIndex>(i)));
+
+    m_flow_graph_.outputCache().insert(m_cache_key_, std::move(outputs));
+}
+
+void Node::eraseDeliveredEmptyInputs()
+{
+    m_inputs_.erase(std::remove_if(m_inputs_.begin(), m_inputs_.end(),
+                                   [](Input const &input)
+    {
+        return !input.stale && !input.data;
+    }), m_inputs_.end());
+}
@@ -59,10 +59,16 @@ bool NodeConnectionInteraction::canConnect(PortIndex &portIndex, TypeConverter &
             converter = _scene->registry().getTypeConverter(candidateNodeDataType , connectionDataType);
         }
 
-        return (converter != nullptr);
+        if (!converter)
+            return false;
     }
 
-    return true;
+    // 5) The connection doesn't close a cycle
+
+    Node *outNode = (requiredPort == PortType::In) ? node : _node;
+    Node *inNode  = (requiredPort == PortType::In) ? _node : node;
+
+    return !_scene->graph().topologicalOrder().createsCycle(outNode, inNode);
 }
 
 bool NodeConnectionInteraction::tryConnect() const
@@ -18,9 +18,11 @@ public:
 
     //! Can connect when following conditions are met:
     //! 1) Connection 'requires' a port
+    //! 1.5) Connection doesn't start at the node itself
     //! 2) Connection's vacant end is above the node port
     //! 3) Node port is vacant
     //! 4) Connection type equals node port type, or there is a registered type conversion that can translate between the two
+    //! 5) Connection doesn't close a cycle
     bool canConnect(PortIndex &portIndex,
                     TypeConverter &converter) const;
 
@@ -1,6 +1,8 @@
 #include "nodedatamodel.h"
 #include "stylecollection.h"
 
+#include <utility>
+
 NodeDataModel::NodeDataModel()
     : m_node_style_(StyleCollection::nodeStyle())
 {
@@ -24,3 +26,13 @@ void NodeDataModel::setNodeStyle(const NodeStyle &style)
 {
     m_node_style_ = style;
 }
+
+CancellationToken const &NodeDataModel::cancellationToken() const
+{
+    return m_cancellation_token_;
+}
+
+void NodeDataModel::setCancellationToken(CancellationToken token)
+{
+    m_cancellation_token_ = std::move(token);
+}
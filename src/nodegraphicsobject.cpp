@@ -117,8 +117,11 @@ void NodeGraphicsObject::moveConnections() const
                 nodeState.getEntries(portType);
 
         for (auto const &connections : connectionEntries) {
-            for (auto &con : connections)
-                con.second->getConnectionGraphicsObject().move();
+            for (auto &con : connections) {
+                // not attached yet while the scene is handling connectionCreated
+                if (con.second->hasGraphicsObject())
+                    con.second->getConnectionGraphicsObject().move();
+            }
         }
     }
 }
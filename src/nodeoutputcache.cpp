@@ -0,0 +1,115 @@
+#include "nodeoutputcache.h"
+
+#include <utility>
+
+#include <QHash>
+
+namespace {
+
+// bookkeeping cost of an entry beyond the data it holds
+constexpr std::size_t EntryOverhead = 256;
+
+}
+
+NodeOutputCache::NodeOutputCache()
+    : _byteBudget(256 * 1024 * 1024),
+      _byteSize(0),
+      _hits(0),
+      _misses(0)
+{}
+
+bool NodeOutputCache::find(Key const &key, Outputs &outputs)
+{
+    auto it = _index.find(key);
+
+    if (it == _index.end()) {
+        ++_misses;
+        return false;
+    }
+
+    ++_hits;
+
+    _entries.splice(_entries.begin(), _entries, it->second);
+    outputs = it->second->outputs;
+
+    return true;
+}
+
+void NodeOutputCache::insert(Key key, Outputs outputs)
+{
+    auto it = _index.find(key);
+    if (it != _index.end()) {
+        _byteSize -= it->second->bytes;
+        _entries.erase(it->second);
+        _index.erase(it);
+    }
+
+    std::size_t bytes = EntryOverhead + static_cast<std::size_t>(key.parameters.size());
+    for (auto const &data : outputs) {
+        if (data)
+            bytes += data->byteSize();
+    }
+
+    if (bytes > _byteBudget)
+        return;
+
+    _entries.push_front({ std::move(key), std::move(outputs), bytes });
+    _index.emplace(_entries.front().key, _entries.begin());
+    _byteSize += bytes;
+
+    evict();
+}
+
+void NodeOutputCache::clear()
+{
+    _index.clear();
+    _entries.clear();
+    _byteSize = 0;
+}
+
+std::size_t NodeOutputCache::byteBudget() const
+{
+    return _byteBudget;
+}
+
+void NodeOutputCache::setByteBudget(std::size_t bytes)
+{
+    _byteBudget = bytes;
+    evict();
+}
+
+std::size_t NodeOutputCache::byteSize() const
+{
+    return _byteSize;
+}
+
+std::size_t NodeOutputCache::hits() const
+{
+    return _hits;
+}
+
+std::size_t NodeOutputCache::misses() const
+{
+    return _misses;
+}
+
+std::size_t NodeOutputCache::KeyHash::operator()(Key const &key) const
+{
+    std::size_t seed = qHash(key.parameters);
+
+    for (std::size_t value : key.inputs)
+        seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+
+    return seed;
+}
+
+void NodeOutputCache::evict()
+{
+    while (_byteSize > _byteBudget && !_entries.empty()) {
+        Entry const &entry = _entries.back();
+
+        _byteSize -= entry.bytes;
+        _index.erase(entry.key);
+        _entries.pop_back();
+    }
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+/**
+ * @brief 协作式取消标记，副本共享同一状态
+ *
+ * 模型在耗时的循环中轮询isCancelled()，被取消后尽早返回
+ */
+class CancellationToken
+{
+public:
+    CancellationToken()
+        : _cancelled(std::make_shared<std::atomic<bool>>(false)) {}
+
+    bool isCancelled() const { return _cancelled->load(std::memory_order_relaxed); }
+    void cancel() const { _cancelled->store(true, std::memory_order_relaxed); }
+
+private:
+    std::shared_ptr<std::atomic<bool>> _cancelled;
+};
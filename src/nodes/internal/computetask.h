@@ -0,0 +1,21 @@
+#pragma once
+
+#include <functional>
+#include <utility>
+
+#include <QRunnable>
+
+/**
+ * @brief 在线程池中执行任意函数的任务
+ */
+class ComputeTask : public QRunnable
+{
+public:
+    explicit ComputeTask(std::function<void()> job)
+        : _job(std::move(job)) {}
+
+    void run() override { _job(); }
+
+private:
+    std::function<void()> _job;
+};
@@ -11,6 +11,7 @@
 #include "connectiongeometry.h"
 #include "typeconverter.h"
 #include "quuidstdhash.h"
+#include "streamchannel.h"
 #include "memory.h"
 
 class QPointF;
@@ -58,6 +59,8 @@ public:
     void removeFromNodes() const;
 
 public:
+    //! 不在场景中显示的连接没有图形对象
+    bool hasGraphicsObject() const;
     ConnectionGraphicsObject &getConnectionGraphicsObject() const;
 
     ConnectionState const &connectionState() const;
@@ -76,9 +79,13 @@ public:
     NodeDataType dataType(PortType portType) const;
 
     void setTypeConverter(TypeConverter converter);
+    TypeConverter const &typeConverter() const;
 
     bool complete() const;
 
+    //! 流式端口使用的有界队列，见StreamNodeDataModel
+    std::shared_ptr<StreamChannel> const &stream() const;
+
 public:
     void propagateData(std::shared_ptr<NodeData> nodeData) const;
     void propagateEmptyData() const;
@@ -105,4 +112,6 @@ private:
     std::unique_ptr<ConnectionGraphicsObject> _connectionGraphicsObject;
 
     TypeConverter _converter;
+
+    std::shared_ptr<StreamChannel> _stream;
 };
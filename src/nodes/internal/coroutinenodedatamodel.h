@@ -0,0 +1,161 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include <QCoreApplication>
+#include <QPointer>
+#include <QThreadPool>
+
+#include "computetask.h"
+#include "nodedatamodel.h"
+
+/**
+ * @brief 节点协程的返回类型（即发即弃）
+ *
+ * 协程帧在协程结束时自行销毁；被取代或模型已删除时，挂起中的协程直接销毁而不再恢复
+ */
+class NodeTask
+{
+public:
+    struct promise_type
+    {
+        NodeTask get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+
+        // 异常无法穿过Qt事件循环
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+/**
+ * @brief 以协程编写计算的节点数据模型
+ *
+ * 子类实现coSetInData()，其中 co_await runAsync(...) 把文件读取、解码等
+ * 耗时工作放到线程池中执行，协程随后在GUI线程上恢复并发出dataUpdated。
+ * 新的输入到来（或调用restart()）会取消仍在等待的旧协程，旧协程不再恢复。
+ */
+class CoroutineNodeDataModel : public NodeDataModel
+{
+    Q_OBJECT
+
+public:
+    void setInData(std::shared_ptr<NodeData> nodeData, PortIndex port) final;
+
+protected:
+    //! 协程版本的setInData，在GUI线程上开始执行
+    virtual NodeTask coSetInData(std::shared_ptr<NodeData> nodeData, PortIndex port);
+
+    //! 取消仍在等待的协程，并返回新一轮计算使用的取消标记
+    CancellationToken const &restart();
+
+    template <typename Function>
+    class AsyncAwaiter;
+
+    //! 在线程池中执行function，协程在GUI线程上恢复并取得其返回值。
+    //! function在工作线程中执行，须可复制、按值捕获，不得访问部件
+    template <typename Function>
+    AsyncAwaiter<std::decay_t<Function>> runAsync(Function &&function)
+    {
+        return AsyncAwaiter<std::decay_t<Function>>(this, std::forward<Function>(function));
+    }
+
+private:
+    /**
+     * @brief 持有挂起的协程，只在GUI线程上恢复或销毁它
+     */
+    class Resumer
+    {
+    public:
+        Resumer(std::coroutine_handle<> handle,
+                QPointer<CoroutineNodeDataModel> model,
+                CancellationToken token)
+            : _handle(handle), _model(std::move(model)), _token(std::move(token)) {}
+
+        Resumer(Resumer const &) = delete;
+        Resumer &operator=(Resumer const &) = delete;
+
+        ~Resumer()
+        {
+            if (_handle)
+                _handle.destroy();
+        }
+
+        void resume()
+        {
+            // 模型已删除或计算已被取代：丢弃协程
+            if (!_model || _token.isCancelled())
+                return;
+
+            std::exchange(_handle, nullptr).resume();
+        }
+
+    private:
+        std::coroutine_handle<> _handle;
+        QPointer<CoroutineNodeDataModel> _model;
+        CancellationToken _token;
+    };
+};
+
+template <typename Function>
+class CoroutineNodeDataModel::AsyncAwaiter
+{
+    using Result = std::invoke_result_t<Function &>;
+
+    struct State
+    {
+        std::conditional_t<std::is_void_v<Result>, bool, std::optional<Result>> result {};
+        std::exception_ptr exception;
+    };
+
+public:
+    AsyncAwaiter(CoroutineNodeDataModel *model, Function function)
+        : _model(model),
+          _function(std::move(function)),
+          _state(std::make_shared<State>()) {}
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        auto resumer = std::make_shared<Resumer>(handle, _model, _model->cancellationToken());
+
+        QThreadPool::globalInstance()->start(
+            new ComputeTask([function = std::move(_function), state = _state,
+                             resumer = std::move(resumer)]() mutable {
+                try {
+                    if constexpr (std::is_void_v<Result>)
+                        function();
+                    else
+                        state->result.emplace(function());
+                } catch (...) {
+                    state->exception = std::current_exception();
+                }
+
+                // qApp活得比所有模型久，真正的检查在GUI线程上进行
+                QMetaObject::invokeMethod(qApp, [resumer = std::move(resumer)] {
+                    resumer->resume();
+                }, Qt::QueuedConnection);
+            }));
+    }
+
+    Result await_resume()
+    {
+        if (_state->exception)
+            std::rethrow_exception(_state->exception);
+
+        if constexpr (!std::is_void_v<Result>)
+            return std::move(*_state->result);
+    }
+
+private:
+    CoroutineNodeDataModel *_model;
+    Function _function;
+    std::shared_ptr<State> _state;
+};
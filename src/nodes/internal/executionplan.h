@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <QUuid>
+
+#include "porttype.h"
+#include "typeconverter.h"
+
+class Node;
+class NodeDataModel;
+
+/**
+ * @brief 编译后的执行计划，用于重复执行同一个图
+ *
+ * 由FlowGraph::compile()生成：按依赖顺序排列的步骤，每一步的模型指针、端口与类型转换器
+ * 都已解析好。run()直接从上游模型读取输出并调用setInData，不经过信号槽、Connection和
+ * 节点的连接表，模型的信号在执行期间被阻塞。
+ *
+ * 计划不随图更新：节点或连接发生变化后须重新编译。
+ * 可记忆化模型的缓存不参与执行；协程模型的结果在之后异步到达，不经过计划。
+ */
+class ExecutionPlan
+{
+public:
+    struct Input
+    {
+        //! 提供数据的步骤的下标，总是小于当前步骤
+        std::size_t sourceStep;
+        PortIndex sourcePort;
+
+        PortIndex port;
+        QUuid connectionId;
+        TypeConverter converter;
+    };
+
+    struct Step
+    {
+        Node *node;
+        NodeDataModel *model;
+
+        //! 按输入端口排列
+        std::vector<Input> inputs;
+    };
+
+public:
+    ExecutionPlan() = default;
+    explicit ExecutionPlan(std::vector<Step> steps);
+
+    std::vector<Step> const &steps() const;
+    bool empty() const;
+
+    //! 按依赖顺序执行一次：没有输入的源步骤不执行，其余每一步读取全部输入并调用setInData
+    void run() const;
+
+    //! 让节点记录计划最后一次执行的输入并刷新界面，与Eager传播后的状态一致
+    void sync() const;
+
+private:
+    std::vector<Step> _steps;
+};
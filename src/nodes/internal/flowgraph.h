@@ -0,0 +1,232 @@
+#pragma once
+
+#include <unordered_map>
+#include <unordered_set>
+#include <set>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <QObject>
+#include <QUuid>
+#include <QThreadPool>
+#include <QJsonObject>
+
+#include "quuidstdhash.h"
+#include "porttype.h"
+#include "datamodelregistry.h"
+#include "typeconverter.h"
+#include "topologicalorder.h"
+#include "nodeoutputcache.h"
+#include "executionplan.h"
+
+class NodeDataModel;
+class Node;
+class Connection;
+
+/**
+ * @brief 数据流图：节点、连接与数据传播，不依赖图形界面
+ *
+ * 节点与连接可以没有图形对象，因此图可以在批处理任务中运行，
+ * 数据传播的开销也与界面无关（带嵌入部件的模型仍需要QApplication）。
+ * FlowScene是图之上的视图适配器，负责为节点和连接创建图形对象。
+ */
+class FlowGraph : public QObject
+{
+    Q_OBJECT
+
+public:
+    //! 数据传播方式
+    enum class PropagationMode
+    {
+        Eager,    //!< 数据更新立即沿连接推送到下游（默认）
+        Dirty,    //!< 数据更新只将下游标记为脏，随后的一次求值按依赖顺序重新计算每个脏节点一次
+        Pull,     //!< 同Dirty，但只计算活动汇点（NodeDataModel::activeSink）上游的脏节点，
+                  //!< 其余节点保持为脏，直到被某个汇点请求
+    };
+
+public:
+    explicit FlowGraph(std::shared_ptr<DataModelRegistry> registry, QObject *parent = nullptr);
+    ~FlowGraph() override;
+
+public:
+    //! 只有一端连接到节点的连接（正在被拖动），两端都连接后发出connectionCreated
+    std::shared_ptr<Connection>
+    createConnection(PortType connectedPort,
+                     Node &node,
+                     PortIndex portIndex);
+
+    //! 连接会形成环时抛出std::logic_error
+    std::shared_ptr<Connection>
+    createConnection(Node &nodeIn,
+                     PortIndex portIndexIn,
+                     Node &nodeOut,
+                     PortIndex portIndexOut,
+                     TypeConverter const &converter = TypeConverter{});
+
+    std::shared_ptr<Connection> restoreConnection(QJsonObject const &connectionJson);
+
+    void deleteConnection(Connection const &connection);
+
+    Node &createNode(std::unique_ptr<NodeDataModel> &&dataModel);
+    Node &restoreNode(QJsonObject const &nodeJson);
+
+    void removeNode(Node &node);
+
+    DataModelRegistry &registry() const;
+    void setRegistry(std::shared_ptr<DataModelRegistry> registry);
+
+    //! 执行异步模型（NodeDataModel::asyncCompute）计算的线程池
+    QThreadPool &threadPool();
+
+    //! 可记忆化模型（NodeDataModel::memoizable）的输出缓存
+    NodeOutputCache &outputCache();
+
+    void iterateOverNodes(std::function<void(Node*)> const &visitor);
+    void iterateOverNodeData(std::function<void(NodeDataModel *)> const &visitor);
+    //! 按依赖顺序访问模型，上游节点总是先于下游节点
+    void iterateOverNodeDataDependentOrder(std::function<void(NodeDataModel *)> const &visitor);
+
+    //! 按依赖顺序对整个图求值一次：每个节点从上游拉取全部输入并调用setInData。
+    //! parallel为true时，节点的最后一个输入就绪后即可运行，互不依赖的异步模型
+    //! 在线程池中并行计算；为false时在当前线程中串行计算，结果相同
+    void evaluate(bool parallel = true);
+
+    //! 把当前的图编译为执行计划，用于以很小的调度开销重复求值。
+    //! 计划在节点或连接变化后失效；执行时图中不应有正在进行的异步计算
+    ExecutionPlan compile() const;
+
+    //! 随连接的创建与删除增量维护的拓扑顺序，图总是无环的
+    TopologicalOrder const &topologicalOrder() const;
+
+    PropagationMode propagationMode() const;
+    void setPropagationMode(PropagationMode mode);
+
+    //! 将node的index输出端口下游的连接标记为脏，并安排一次evaluateDirty
+    void markDirty(Node &node, PortIndex index);
+
+    //! 按依赖顺序重新计算所有脏节点，每个节点只读取其脏连接上最新的上游数据。
+    //! 拉取模式下只计算活动汇点上游的脏节点
+    void evaluateDirty();
+
+    //! 立即计算sink上游（含sink自身）的所有脏节点，与传播方式无关
+    void requestInputs(Node &sink);
+
+    //! 开始一次传播事务：事务期间传播到节点的数据被暂存，每个(节点, 端口, 连接)只保留最新值。
+    //! 可嵌套，最外层的endUpdate按依赖顺序提交，每个节点只接收一次，其下游也只更新一次
+    void beginUpdate();
+    void endUpdate();
+
+    //! 事务期间暂存传播到node的数据并返回true，否则返回false
+    bool deferPropagation(Node &node,
+                          std::shared_ptr<NodeData> &nodeData,
+                          PortIndex portIndex,
+                          QUuid const &connectionId);
+
+public:
+    std::unordered_map<QUuid, std::unique_ptr<Node> > const &nodes() const;
+    std::unordered_map<QUuid, std::shared_ptr<Connection> > const &connections() const;
+    std::vector<Node *> allNodes() const;
+
+public:
+    void clear();
+
+    QByteArray saveToMemory() const;
+    void loadFromMemory(const QByteArray &data);
+
+signals:
+    //! 节点已创建
+    void nodeCreated(Node &n);
+
+    //! 节点已从保存的数据中恢复，带有位置
+    void nodePlaced(Node &n);
+    void nodeDeleted(Node &n);
+
+    void connectionCreated(Connection const &c);
+    void connectionDeleted(Connection const &c);
+
+private:
+    using SharedConnection = std::shared_ptr<Connection>;
+    using UniqueNode       = std::unique_ptr<Node>;
+
+    // DO NOT reorder this member to go after the others.
+    // This should outlive all the connections and nodes of
+    // the graph, so that nodes can potentially have pointers into it,
+    // which is why it comes first in the class.
+    std::shared_ptr<DataModelRegistry> _registry;
+
+    // Must outlive the nodes, whose pending jobs it runs.
+    QThreadPool _threadPool;
+
+    std::unordered_map<QUuid, SharedConnection> _connections;
+    std::unordered_map<QUuid, UniqueNode>       _nodes;
+
+    TopologicalOrder _topologicalOrder;
+
+    NodeOutputCache _outputCache;
+
+    PropagationMode _propagationMode;
+
+    // dirty connections of every node waiting for evaluateDirty
+    std::unordered_map<Node *, std::vector<QUuid>> _dirtyInputs;
+    // (position, node) of the dirty nodes, only used during evaluateDirty
+    std::set<std::pair<int, Node *>> _dirtyQueue;
+    bool _dirtyEvaluationScheduled;
+    bool _evaluatingDirty;
+
+    // the upstream cone the dirty evaluation is restricted to
+    std::unordered_set<Node *> _requestedNodes;
+    bool _restrictToRequested;
+
+    struct DeferredInput
+    {
+        std::shared_ptr<NodeData> data;
+        PortIndex port;
+        QUuid connectionId;
+    };
+
+    // data deferred by beginUpdate() until the outermost endUpdate()
+    std::unordered_map<Node *, std::vector<DeferredInput>> _deferredInputs;
+    // (position, node) of the nodes with deferred data, only used while committing
+    std::set<std::pair<int, Node *>> _deferredQueue;
+    int _updateDepth;
+    bool _committingUpdate;
+
+private:
+    //! 将sinks及其上游的所有节点设为求值范围
+    void requestUpstreamCone(std::vector<Node *> const &sinks);
+    bool isRequested(Node *node) const;
+
+    void evaluateDirtyNodes();
+
+private slots:
+    void setupConnectionSignals(Connection const &c);
+    void insertConnectionIntoOrder(Connection const &c);
+    void removeConnectionFromOrder(Connection const &c);
+    void sendConnectionCreatedToNodes(Connection const &c);
+    void sendConnectionDeletedToNodes(Connection const &c);
+};
+
+/**
+ * @brief 在作用域内开启一次传播事务
+ */
+class PropagationBatch
+{
+public:
+    explicit PropagationBatch(FlowGraph &graph)
+        : _graph(graph)
+    {
+        _graph.beginUpdate();
+    }
+
+    ~PropagationBatch()
+    {
+        _graph.endUpdate();
+    }
+
+    PropagationBatch(PropagationBatch const &) = delete;
+    PropagationBatch &operator=(PropagationBatch const &) = delete;
+
+private:
+    FlowGraph &_graph;
+};
@@ -3,6 +3,7 @@
 #include <unordered_map>
 #include <tuple>
 #include <functional>
+#include <vector>
 
 #include <QUuid>
 #include <QGraphicsScene>
@@ -10,6 +11,7 @@
 #include "quuidstdhash.h"
 #include "datamodelregistry.h"
 #include "typeconverter.h"
+#include "flowgraph.h"
 
 class NodeDataModel;
 class FlowItemInterface;
@@ -21,6 +23,9 @@ class NodeStyle;
 
 /**
  * @brief 场景包含连接和节点
+ *
+ * 场景是FlowGraph的视图适配器：图中的节点和连接在这里获得图形对象，
+ * 数据传播与求值由graph()负责
  */
 class FlowScene : public QGraphicsScene
 {
@@ -31,12 +36,17 @@ public:
     FlowScene(QObject *parent = nullptr);
     ~FlowScene();
 
+public:
+    FlowGraph &graph();
+    FlowGraph const &graph() const;
+
 public:
     std::shared_ptr<Connection>
     createConnection(PortType connectedPort,
                      Node &node,
                      PortIndex portIndex);
 
+    //! 连接会形成环时抛出std::logic_error
     std::shared_ptr<Connection>
     createConnection(Node &nodeIn,
                      PortIndex portIndexIn,
@@ -58,8 +68,12 @@ public:
 
     void iterateOverNodes(std::function<void(Node*)> const &visitor);
     void iterateOverNodeData(std::function<void(NodeDataModel *)> const &visitor);
+    //! 按依赖顺序访问模型，上游节点总是先于下游节点
     void iterateOverNodeDataDependentOrder(std::function<void(NodeDataModel *)> const &visitor);
 
+    //! 见FlowGraph::compile
+    ExecutionPlan compile() const;
+
     QPointF getNodePosition(Node const &node) const;
 
     void setNodePosition(Node &node, QPointF const &pos) const;
@@ -100,22 +114,16 @@ signals:
     void nodeContextMenu(Node &n, const QPointF &pos);
 
 private:
-    using SharedConnection = std::shared_ptr<Connection>;
-    using UniqueNode       = std::unique_ptr<Node>;
-
-    // DO NOT reorder this member to go after the others.
-    // This should outlive all the connections and nodes of
-    // the graph, so that nodes can potentially have pointers into it,
-    // which is why it comes first in the class.
-    std::shared_ptr<DataModelRegistry> _registry;
-
-    std::unordered_map<QUuid, SharedConnection> _connections;
-    std::unordered_map<QUuid, UniqueNode>       _nodes;
+    //! 为还没有图形对象的节点创建图形对象
+    void attachGraphicsObject(Node &node);
 
 private slots:
-    void setupConnectionSignals(Connection const &c);
-    void sendConnectionCreatedToNodes(Connection const &c);
-    void sendConnectionDeletedToNodes(Connection const &c);
+    void onNodeCreated(Node &node);
+    void onNodePlaced(Node &node);
+    void onConnectionCreated(Connection const &c);
+
+private:
+    FlowGraph _graph;
 };
 
 Node *locateNodeAt(QPointF scenePoint, FlowScene &scene,
@@ -1,8 +1,12 @@
 #pragma once
 
+#include <memory>
+#include <vector>
+
 #include <QObject>
 #include <QUuid>
 #include <QJsonObject>
+#include <QPointF>
 
 #include "porttype.h"
 #include "nodestate.h"
@@ -11,11 +15,13 @@
 #include "nodegraphicsobject.h"
 #include "connectiongraphicsobject.h"
 #include "serializable.h"
+#include "nodeoutputcache.h"
 
 class Connection;
 class ConnectionState;
 class NodeGraphicsObject;
 class NodeDataModel;
+class FlowGraph;
 
 class Node : public QObject, public Serializable
 {
@@ -23,7 +29,7 @@ class Node : public QObject, public Serializable
 
 public:
     //! NodeDataModel应为右值，并移动到节点中
-    Node(std::unique_ptr<NodeDataModel> &&dataModel);
+    Node(std::unique_ptr<NodeDataModel> &&dataModel, FlowGraph &graph);
     virtual ~Node();
 
 public:
@@ -38,24 +44,48 @@ public:
     void resetReactionToConnection();
 
 public:
+    //! 不在场景中显示的节点（如批处理中）没有图形对象
+    bool hasGraphicsObject() const;
+
     NodeGraphicsObject const &nodeGraphicsObject() const;
     NodeGraphicsObject &nodeGraphicsObject();
 
     void setGraphicsObject(std::unique_ptr<NodeGraphicsObject> &&graphics);
 
+    //! 几何信息在第一次使用时才创建（需要QGuiApplication）
+
     NodeGeometry &nodeGeometry();
     NodeGeometry const &nodeGeometry() const;
     NodeState const &nodeState() const;
     NodeState &nodeState();
     NodeDataModel *nodeDataModel() const;
 
+public:
+    //! 节点当前的输出：若输出来自缓存则返回缓存的数据，否则读取模型
+    std::shared_ptr<NodeData> outData(PortIndex index) const;
+
+    //! 每次有数据传播到节点时递增
+    quint64 generation() const;
+
+    //! 记录一个已由外部（如FlowGraph::evaluate）直接交给模型的输入
+    void inputDelivered(std::shared_ptr<NodeData> nodeData,
+                        PortIndex inPortIndex,
+                        const QUuid &connectionId);
+
 public slots:
-    //! 将传入数据传播到基础模型。
+    //! 将传入数据传播到基础模型，场景处于传播事务中时暂存到事务提交
     void propagateData(std::shared_ptr<NodeData> nodeData,
                        PortIndex inPortIndex,
-                       const QUuid &connectionId) const;
+                       const QUuid &connectionId);
 
-    //! 从模型的out索引端口获取数据并将其传播到连接
+    //! 立即将数据交给模型，若模型支持异步计算，则交由图的线程池执行；
+    //! 可记忆化的模型在缓存命中时跳过计算
+    void deliverData(std::shared_ptr<NodeData> nodeData,
+                     PortIndex inPortIndex,
+                     const QUuid &connectionId);
+
+    //! 从模型的out索引端口获取数据并将其传播到连接，
+    //! 脏标记模式下只将下游标记为脏
     void onDataUpdated(PortIndex index);
 
     //! 将空数据传播到连接
@@ -64,11 +94,75 @@ public slots:
     //! 如果embeddedwidget的大小更改，则更新图形部件
     void onNodeSizeUpdated();
 
+public:
+    //! 数据变化可能导致节点尺寸变化，重新计算并重绘
+    void recalculateVisuals();
+
+private slots:
+    //! 模型自身发出的dataUpdated
+    void onModelDataUpdated(PortIndex index);
+
+    //! 工作线程完成计算后在GUI线程中调用
+    void onComputeFinished();
+
+private:
+    struct Input
+    {
+        PortIndex port;
+        QUuid connectionId;
+        std::shared_ptr<NodeData> data;
+
+        // the model hasn't received the data yet
+        bool stale;
+    };
+
+    struct ComputeState;
+
+private:
+    Input &recordInput(PortIndex port, QUuid const &connectionId);
+    bool hasStaleInputs() const;
+
+    //! 同步地将所有过期输入交给模型
+    void computeStaleInputs();
+
+    //! 若当前没有正在进行的计算，则将所有过期输入派发到线程池
+    void scheduleCompute();
+
+    //! 以当前输入查询输出缓存，命中时传播缓存的输出并返回true
+    bool serveFromCache();
+    void storeInCache();
+
+    //! 删除已交给模型的空输入（连接已断开）
+    void eraseDeliveredEmptyInputs();
+
 private:
     std::unique_ptr<NodeDataModel> m_node_data_model_;    // data
     std::unique_ptr<NodeGraphicsObject> m_node_graphics_object_;
+    FlowGraph &m_flow_graph_;
+
+    // 每个(端口, 连接)上最新的输入。异步计算时每个节点同一时刻最多只有一个任务，
+    // 计算期间到达的输入只保留最新值，任务结束后一并派发
+    std::vector<Input> m_inputs_;
+
+    // 非空时输出来自缓存，模型尚未收到对应的输入
+    NodeOutputCache::Outputs m_cached_outputs_;
+    NodeOutputCache::Key m_cache_key_;
+    bool m_cache_key_valid_;
+
+    std::shared_ptr<ComputeState> m_compute_state_;
+    bool m_computing_;
+
+    // 输入的代数；任务结束时若代数已变化，说明结果已被更新的输入取代，直接丢弃
+    quint64 m_generation_;
+    quint64 m_job_generation_;
+
+    // 计算期间模型更新的输出端口，任务结束后再传播
+    std::vector<PortIndex> m_updated_ports_;
 
     QUuid m_uuid_;
     NodeState m_node_state_;
-    NodeGeometry m_node_geometry_;    // painting
+    mutable std::unique_ptr<NodeGeometry> m_node_geometry_;    // painting
+
+    // 没有图形对象时保存与恢复的位置
+    QPointF m_position_;
 };
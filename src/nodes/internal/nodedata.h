@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+
 #include <QString>
 
 struct NodeDataType
@@ -35,4 +37,12 @@ public:
 
     //! 内部使用类型
     virtual NodeDataType type() const = 0;
+
+    //! 内容哈希，内容相同的数据应返回相同的值，用于缓存节点输出；
+    //! 返回0表示数据不可哈希，接收它的节点不会被缓存。
+    //! 内容只能按需计算的数据可以按对象返回，这样内容相同的另一份数据总是缓存未命中
+    virtual std::size_t hash() const { return 0; }
+
+    //! 数据占用内存的估计（字节），用于缓存预算
+    virtual std::size_t byteSize() const { return 0; }
 };
@@ -7,6 +7,7 @@
 #include "serializable.h"
 #include "nodestyle.h"
 #include "nodepainterdelegate.h"
+#include "cancellationtoken.h"
 
 class NodePainterDelegate;
 
@@ -71,6 +72,11 @@ public:
     const NodeStyle &nodeStyle() const;
     void setNodeStyle(const NodeStyle &style);
 
+    //! 当前异步计算的取消标记：计算被更新的输入取代或节点被删除时置位，
+    //! 耗时的setInData应定期检查并尽早返回，被取消的结果不会被传播
+    CancellationToken const &cancellationToken() const;
+    void setCancellationToken(CancellationToken token);
+
 public:
     //! 触发算法
     virtual void setInData(std::shared_ptr<NodeData> nodeData, PortIndex port) = 0;
@@ -89,6 +95,19 @@ public:
 
     virtual bool resizable() const { return false; }
 
+    //! 返回true时，setInData将被派发到图的线程池中执行。
+    //! 此类模型的setInData/outData必须是线程安全的，且不能访问嵌入部件；
+    //! 部件的刷新可放在连接到computingFinished的槽中（GUI线程）
+    virtual bool asyncCompute() const { return false; }
+
+    //! 返回true表示输出只取决于输入与save()保存的参数。
+    //! 图据此缓存输出，输入与参数曾经出现过时跳过setInData
+    virtual bool memoizable() const { return false; }
+
+    //! 返回true表示模型消费其输入（显示、保存等）。拉取模式下只有活动汇点上游的节点被计算，
+    //! 汇点由不活动变为活动时应调用FlowGraph::requestInputs
+    virtual bool activeSink() const { return false; }
+
     virtual NodeValidationState validationState() const { return NodeValidationState::Valid; }
 
     virtual QString validationMessage() const { return QString(""); }
@@ -119,6 +138,7 @@ signals:
     //! 触发下游空数据的传播。
     void dataInvalidated(PortIndex index);
 
+    //! 异步计算开始/结束，均在GUI线程中发出
     void computingStarted();
     void computingFinished();
 
@@ -126,4 +146,5 @@ signals:
 
 private:
     NodeStyle m_node_style_;
+    CancellationToken m_cancellation_token_;
 };
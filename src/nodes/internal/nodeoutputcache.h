@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <QByteArray>
+
+#include "nodedata.h"
+
+/**
+ * @brief 纯函数节点输出的记忆化缓存，按字节预算做LRU淘汰
+ *
+ * 键由模型序列化后的参数（NodeDataModel::save）与所有输入数据的内容哈希组成，
+ * 参数与输入都相同的节点共享同一条缓存。只在GUI线程中使用
+ */
+class NodeOutputCache
+{
+public:
+    struct Key
+    {
+        QByteArray parameters;
+
+        //! 非空输入的(端口, 内容哈希)依次排列
+        std::vector<std::size_t> inputs;
+
+        friend bool operator==(Key const &k1, Key const &k2)
+        {
+            return k1.parameters == k2.parameters && k1.inputs == k2.inputs;
+        }
+    };
+
+    using Outputs = std::vector<std::shared_ptr<NodeData>>;
+
+public:
+    NodeOutputCache();
+
+    //! 命中时写入outputs并返回true
+    bool find(Key const &key, Outputs &outputs);
+    void insert(Key key, Outputs outputs);
+
+    void clear();
+
+    std::size_t byteBudget() const;
+    void setByteBudget(std::size_t bytes);
+
+    //! 当前缓存占用的字节数估计
+    std::size_t byteSize() const;
+
+    std::size_t hits() const;
+    std::size_t misses() const;
+
+private:
+    struct KeyHash
+    {
+        std::size_t operator()(Key const &key) const;
+    };
+
+    struct Entry
+    {
+        Key key;
+        Outputs outputs;
+        std::size_t bytes;
+    };
+
+    using EntryList = std::list<Entry>;
+
+    void evict();
+
+private:
+    // most recently used first
+    EntryList _entries;
+    std::unordered_map<Key, EntryList::iterator, KeyHash> _index;
+
+    std::size_t _byteBudget;
+    std::size_t _byteSize;
+
+    std::size_t _hits;
+    std::size_t _misses;
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "porttype.h"
+#include "nodedata.h"
+
+class FlowGraph;
+class Node;
+
+/**
+ * @brief 帧序列的流水线执行器
+ *
+ * 源节点某个输出端口下游的每个节点构成一级流水线，相邻两级之间经由无锁SPSC队列传递帧，
+ * 第K级处理第i+1帧时第K+1级可以同时处理第i帧。异步模型（NodeDataModel::asyncCompute）
+ * 各自占用一个线程，其余模型在调用线程中轮流执行。
+ *
+ * 与Connection::propagateData的逐帧深度优先传播不同，执行期间模型的信号被阻塞，
+ * 结束后各节点记录最后一帧的输入。
+ */
+class PipelineExecutor
+{
+public:
+    //! 返回下一帧，序列结束时返回nullptr（在调用线程中调用）
+    using FrameSource = std::function<std::shared_ptr<NodeData>()>;
+
+    struct StageReport
+    {
+        Node *node;
+        bool threaded;
+
+        //! 花在setInData/outData上的时间
+        double busySeconds;
+    };
+
+    struct Report
+    {
+        std::size_t frames = 0;
+        double seconds = 0.0;
+        double framesPerSecond = 0.0;
+
+        std::vector<StageReport> stages;
+    };
+
+public:
+    explicit PipelineExecutor(FlowGraph &graph, std::size_t queueCapacity = 4);
+
+    //! 把frames作为source节点port端口的输出逐帧送入流水线，阻塞到最后一帧处理完毕。
+    //! source的模型本身不参与计算
+    Report run(Node &source, PortIndex port, FrameSource frames);
+
+private:
+    FlowGraph &_graph;
+    std::size_t _queueCapacity;
+};
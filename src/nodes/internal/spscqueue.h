@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief 有界无锁单生产者单消费者队列
+ *
+ * tryPush只能在一个线程中调用，tryPop只能在另一个线程中调用
+ */
+template <typename T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(std::size_t capacity)
+        : _slots(capacity + 1) {}
+
+    SpscQueue(SpscQueue const &) = delete;
+    SpscQueue &operator=(SpscQueue const &) = delete;
+
+    std::size_t capacity() const { return _slots.size() - 1; }
+
+    //! 队列已满时返回false，value保持不变
+    bool tryPush(T &&value)
+    {
+        std::size_t const tail = _tail.load(std::memory_order_relaxed);
+        std::size_t const next = advance(tail);
+
+        if (next == _head.load(std::memory_order_acquire))
+            return false;
+
+        _slots[tail] = std::move(value);
+        _tail.store(next, std::memory_order_release);
+
+        return true;
+    }
+
+    bool tryPop(T &value)
+    {
+        std::size_t const head = _head.load(std::memory_order_relaxed);
+
+        if (head == _tail.load(std::memory_order_acquire))
+            return false;
+
+        value = std::move(_slots[head]);
+        _head.store(advance(head), std::memory_order_release);
+
+        return true;
+    }
+
+    //! 近似的元素个数，任意线程均可调用
+    std::size_t size() const
+    {
+        std::size_t const head = _head.load(std::memory_order_acquire);
+        std::size_t const tail = _tail.load(std::memory_order_acquire);
+
+        return tail >= head ? tail - head : tail + _slots.size() - head;
+    }
+
+private:
+    std::size_t advance(std::size_t index) const
+    {
+        return index + 1 == _slots.size() ? 0 : index + 1;
+    }
+
+private:
+    std::vector<T> _slots;
+
+    // 分别由消费者与生产者写入，放在不同的缓存行上
+    alignas(64) std::atomic<std::size_t> _head {0};
+    alignas(64) std::atomic<std::size_t> _tail {0};
+};
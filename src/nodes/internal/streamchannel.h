@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+#include "nodedata.h"
+#include "spscqueue.h"
+
+/**
+ * @brief 连接上的数据流：一个有界无锁队列及其统计
+ *
+ * 生产者为连接输出端的模型，消费者为输入端的模型；连接删除时通道被关闭
+ */
+class StreamChannel
+{
+public:
+    static constexpr std::size_t DefaultCapacity = 8;
+
+    explicit StreamChannel(std::size_t capacity = DefaultCapacity);
+
+public:
+    bool tryPush(std::shared_ptr<NodeData> &&data);
+    std::shared_ptr<NodeData> tryPop();
+
+    //! 记录一个因队列已满而被丢弃的元素
+    void recordDrop();
+
+    void close();
+    bool isClosed() const;
+
+public:
+    std::size_t capacity() const;
+
+    //! 当前队列深度
+    std::size_t depth() const;
+
+    //! 出现过的最大队列深度
+    std::size_t maxDepth() const;
+
+    std::size_t pushedCount() const;
+    std::size_t poppedCount() const;
+    std::size_t droppedCount() const;
+
+private:
+    SpscQueue<std::shared_ptr<NodeData>> _queue;
+
+    std::atomic<bool> _closed {false};
+
+    std::atomic<std::size_t> _maxDepth {0};
+    std::atomic<std::size_t> _pushed {0};
+    std::atomic<std::size_t> _popped {0};
+    std::atomic<std::size_t> _dropped {0};
+};
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <QMutex>
+#include <QUuid>
+
+#include "nodedatamodel.h"
+#include "streamchannel.h"
+#include "typeconverter.h"
+
+/**
+ * @brief 以数据流方式工作的节点数据模型
+ *
+ * 端口上传递的不再是单个快照，而是经由每个连接上的有界队列（StreamChannel）传递的元素序列。
+ * 生产者调用pushOut()，可在任意一个固定的线程中调用；消费者在inputAvailable()中
+ * 反复调用pullIn()直到取空。非流式的上游节点送来的快照也会进入队列，
+ * 非流式的下游节点则收到最近一次pushOut()的元素。
+ *
+ * 重写inputConnectionCreated等连接回调时必须调用基类实现。
+ */
+class StreamNodeDataModel : public NodeDataModel
+{
+    Q_OBJECT
+
+public:
+    //! 输出队列已满时的策略
+    enum class Backpressure
+    {
+        Block, //!< 等待消费者；在GUI线程中无法等待，退化为Drop
+        Drop,  //!< 丢弃新元素
+    };
+
+    virtual Backpressure backpressure(PortIndex) const { return Backpressure::Block; }
+
+    //! 单个连接的队列统计
+    struct ChannelStats
+    {
+        QUuid connectionId;
+        PortType portType;
+        PortIndex port;
+
+        std::size_t depth;
+        std::size_t maxDepth;
+        std::size_t capacity;
+        std::size_t pushed;
+        std::size_t popped;
+        std::size_t dropped;
+    };
+
+    //! 本节点所有输入连接与通往流模型的输出连接的队列统计，可用于定位瓶颈
+    std::vector<ChannelStats> streamStats() const;
+
+public:
+    void setInData(std::shared_ptr<NodeData> nodeData, PortIndex port) final;
+    void setInData(std::shared_ptr<NodeData> nodeData, PortIndex port, const QUuid &connectionId) final;
+
+    //! 最近一次pushOut()的元素
+    std::shared_ptr<NodeData> outData(PortIndex port) override;
+
+public slots:
+    void inputConnectionCreated(Connection const &connection) override;
+    void inputConnectionDeleted(Connection const &connection) override;
+    void outputConnectionCreated(Connection const &connection) override;
+    void outputConnectionDeleted(Connection const &connection) override;
+
+protected:
+    //! 把data送入port上通往流模型的所有连接，返回成功入队的连接数
+    std::size_t pushOut(PortIndex port, std::shared_ptr<NodeData> data);
+
+    //! 从port取出下一个元素，队列为空时返回nullptr。多个输入连接轮流读取
+    std::shared_ptr<NodeData> pullIn(PortIndex port);
+
+    //! port上有新元素可取（GUI线程）
+    virtual void inputAvailable(PortIndex port) { Q_UNUSED(port); }
+
+private:
+    struct InputChannel
+    {
+        QUuid connectionId;
+        PortIndex port;
+        std::shared_ptr<StreamChannel> channel;
+        TypeConverter converter;
+
+        // 上游不是流模型，由本模型把收到的快照放入队列
+        bool bridged;
+    };
+
+    struct OutputChannel
+    {
+        QUuid connectionId;
+        PortIndex port;
+        std::shared_ptr<StreamChannel> channel;
+    };
+
+    struct OutputPort
+    {
+        std::shared_ptr<NodeData> latest;
+
+        // 已发出dataUpdated但下游尚未读取outData，合并后续的通知
+        bool notifyPending = false;
+    };
+
+    mutable QMutex _streamMutex;
+
+    std::vector<InputChannel> _inputs;
+    std::vector<OutputChannel> _outputs;
+    std::unordered_map<PortIndex, OutputPort> _outputPorts;
+    std::unordered_map<PortIndex, std::size_t> _pullCursor;
+};
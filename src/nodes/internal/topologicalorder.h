@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+class Node;
+
+/**
+ * @brief 增量维护的拓扑顺序（Pearce–Kelly算法）
+ *
+ * 插入边时只重排位于两端点之间且受影响的节点，删除边不需要重排。
+ * 顺序同时用于剪枝可达性查询，判断一条新边是否会形成环通常为O(1)。
+ * 所有函数都须在GUI线程中调用
+ */
+class TopologicalOrder
+{
+public:
+    void addNode(Node *node);
+
+    //! 同时移除与该节点相连的所有边
+    void removeNode(Node *node);
+
+    //! 插入边from→to，重复的边按次数计；会形成环时不插入并返回false
+    bool addEdge(Node *from, Node *to);
+    void removeEdge(Node *from, Node *to);
+
+    //! 是否存在从from到to的路径（from == to时为true）
+    bool reaches(Node const *from, Node const *to) const;
+
+    //! 插入边from→to是否会形成环
+    bool createsCycle(Node const *from, Node const *to) const;
+
+    //! 节点在顺序中的位置，上游节点的位置总是更小；未知节点返回-1
+    int position(Node const *node) const;
+
+    //! 按拓扑顺序排列的所有节点
+    std::vector<Node *> nodes() const;
+
+    std::size_t size() const;
+
+private:
+    // slot -> number of connections between the two nodes
+    using Edges = std::unordered_map<int, int>;
+
+    int slot(Node const *node) const;
+
+    //! 从start出发沿边（forward为false时逆向）遍历位置在[lower, upper]内的节点，
+    //! 遇到target时停止并返回false
+    bool collect(int start, bool forward, int lower, int upper, int target,
+                 std::vector<int> &visited) const;
+
+    //! 将backward整体排在forward之前，复用两者原来占据的位置
+    void reorder(std::vector<int> &backward, std::vector<int> &forward);
+
+    void compact();
+
+private:
+    std::unordered_map<Node const *, int> _slots;
+
+    std::vector<Node *> _nodes;      // slot -> node, nullptr for free slots
+    std::vector<int> _positions;     // slot -> position
+    std::vector<int> _order;         // position -> slot, -1 for holes
+    std::vector<Edges> _successors;
+    std::vector<Edges> _predecessors;
+
+    std::vector<int> _freeSlots;
+    std::size_t _holes = 0;
+
+    // depth first search marks, indexed by slot
+    mutable std::vector<char> _marks;
+};
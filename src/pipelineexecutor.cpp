@@ -0,0 +1,323 @@
+#include "pipelineexecutor.h"
+
+#include <algorithm>
+#include <chrono>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+#include "connection.h"
+#include "flowgraph.h"
+#include "node.h"
+#include "nodedatamodel.h"
+#include "spscqueue.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Packet
+{
+    std::shared_ptr<NodeData> data;
+
+    //! 序列结束
+    bool end = false;
+};
+
+struct Edge
+{
+    Edge(std::size_t capacity, Connection const &connection)
+        : queue(capacity),
+          port(connection.getPortIndex(PortType::In)),
+          connectionId(connection.id()),
+          converter(connection.typeConverter()) {}
+
+    SpscQueue<Packet> queue;
+
+    PortIndex port;
+    QUuid connectionId;
+    TypeConverter converter;
+};
+
+struct Stage
+{
+    Node *node = nullptr;
+    bool threaded = false;
+
+    //! 只有源级使用
+    PipelineExecutor::FrameSource *frames = nullptr;
+    std::size_t frameCount = 0;
+
+    std::vector<Edge *> inputs;
+    std::vector<std::pair<PortIndex, Edge *>> outputs;
+
+    std::vector<std::optional<Packet>> inbox;
+    std::vector<std::optional<Packet>> outbox;
+    std::vector<std::shared_ptr<NodeData>> lastInputs;
+
+    bool ending = false;
+    bool finished = false;
+    Clock::duration busy {};
+};
+
+//! 计算一帧的输出并放入outbox
+void compute(Stage &stage)
+{
+    auto const start = Clock::now();
+
+    std::shared_ptr<NodeData> frame;
+    bool end = false;
+
+    if (stage.frames) {
+        frame = (*stage.frames)();
+        end = !frame;
+
+        if (!end)
+            ++stage.frameCount;
+    } else {
+        // 各输入上的帧是对齐的，结束标记同时到达
+        end = stage.inbox.front()->end;
+    }
+
+    if (end) {
+        for (auto &packet : stage.outbox)
+            packet = Packet{nullptr, true};
+
+        stage.ending = true;
+        return;
+    }
+
+    std::unordered_map<PortIndex, std::shared_ptr<NodeData>> outputs;
+
+    if (!stage.frames) {
+        NodeDataModel *model = stage.node->nodeDataModel();
+
+        for (std::size_t i = 0; i < stage.inputs.size(); ++i) {
+            Edge const &edge = *stage.inputs[i];
+
+            auto data = std::move(stage.inbox[i]->data);
+            if (edge.converter)
+                data = edge.converter(data);
+
+            model->setInData(data, edge.port, edge.connectionId);
+            stage.lastInputs[i] = std::move(data);
+        }
+
+        for (auto const &output : stage.outputs) {
+            if (outputs.count(output.first) == 0)
+                outputs[output.first] = model->outData(output.first);
+        }
+    }
+
+    for (std::size_t i = 0; i < stage.outputs.size(); ++i)
+        stage.outbox[i] = Packet{stage.frames ? frame : outputs[stage.outputs[i].first], false};
+
+    for (auto &packet : stage.inbox)
+        packet.reset();
+
+    stage.busy += Clock::now() - start;
+}
+
+//! 非阻塞地推进一步，没有任何进展时返回false
+bool step(Stage &stage)
+{
+    bool progress = false;
+    bool pending = false;
+
+    for (std::size_t i = 0; i < stage.outputs.size(); ++i) {
+        auto &packet = stage.outbox[i];
+
+        if (packet && stage.outputs[i].second->queue.tryPush(std::move(*packet))) {
+            packet.reset();
+            progress = true;
+        }
+
+        pending = pending || packet.has_value();
+    }
+
+    if (pending)
+        return progress;
+
+    if (stage.ending) {
+        stage.finished = true;
+        return true;
+    }
+
+    bool complete = true;
+
+    for (std::size_t i = 0; i < stage.inputs.size(); ++i) {
+        if (stage.inbox[i])
+            continue;
+
+        Packet packet;
+        if (stage.inputs[i]->queue.tryPop(packet)) {
+            stage.inbox[i] = std::move(packet);
+            progress = true;
+        } else {
+            complete = false;
+        }
+    }
+
+    if (!complete)
+        return progress;
+
+    compute(stage);
+
+    return true;
+}
+
+//! 等待队列时先让出时间片，长时间空闲后改为休眠
+class Backoff
+{
+public:
+    void idle()
+    {
+        if (++_attempts < 64)
+            std::this_thread::yield();
+        else
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+
+    void reset() { _attempts = 0; }
+
+private:
+    int _attempts = 0;
+};
+
+}
+
+PipelineExecutor::PipelineExecutor(FlowGraph &graph, std::size_t queueCapacity)
+    : _graph(graph),
+      _queueCapacity(std::max<std::size_t>(queueCapacity, 1))
+{
+}
+
+PipelineExecutor::Report PipelineExecutor::run(Node &source, PortIndex port, FrameSource frames)
+{
+    // Jobs started by the regular data propagation must not touch
+    // the models while the pipeline runs.
+    _graph.threadPool().waitForDone();
+
+    std::vector<std::unique_ptr<Edge>> edges;
+    std::vector<std::unique_ptr<Stage>> stages;
+    std::unordered_map<Node *, Stage *> stageOf;
+
+    auto addStage = [&](Node *node) {
+        stages.push_back(std::make_unique<Stage>());
+        stages.back()->node = node;
+        stageOf[node] = stages.back().get();
+        return stages.back().get();
+    };
+
+    Stage *sourceStage = addStage(&source);
+    sourceStage->frames = &frames;
+
+    // 源端口下游所有节点各成一级，按拓扑顺序连接，保证每条边的两端都已建立
+    for (Node *node : _graph.topologicalOrder().nodes()) {
+        auto it = stageOf.find(node);
+        if (it == stageOf.end())
+            continue;
+
+        Stage *stage = it->second;
+        auto const &entries = node->nodeState().getEntries(PortType::Out);
+
+        for (std::size_t outPort = 0; outPort < entries.size(); ++outPort) {
+            if (stage == sourceStage && static_cast<PortIndex>(outPort) != port)
+                continue;
+
+            for (auto const &pair : entries[outPort]) {
+                Connection const &connection = *pair.second;
+
+                Node *inNode = connection.getNode(PortType::In);
+                if (inNode == nullptr)
+                    continue;
+
+                Stage *next = stageOf.count(inNode) ? stageOf[inNode] : addStage(inNode);
+
+                edges.push_back(std::make_unique<Edge>(_queueCapacity, connection));
+                stage->outputs.emplace_back(static_cast<PortIndex>(outPort), edges.back().get());
+                next->inputs.push_back(edges.back().get());
+            }
+        }
+    }
+
+    std::vector<bool> signalsBlocked(stages.size());
+
+    for (std::size_t i = 0; i < stages.size(); ++i) {
+        Stage &stage = *stages[i];
+
+        stage.inbox.resize(stage.inputs.size());
+        stage.outbox.resize(stage.outputs.size());
+        stage.lastInputs.resize(stage.inputs.size());
+        stage.threaded = !stage.frames && stage.node->nodeDataModel()->asyncCompute();
+
+        signalsBlocked[i] = stage.node->nodeDataModel()->blockSignals(true);
+    }
+
+    auto const start = Clock::now();
+
+    std::vector<std::thread> threads;
+
+    for (auto const &threaded : stages) {
+        if (!threaded->threaded)
+            continue;
+
+        threads.emplace_back([&stage = *threaded] {
+            Backoff backoff;
+
+            while (!stage.finished) {
+                if (step(stage))
+                    backoff.reset();
+                else
+                    backoff.idle();
+            }
+        });
+    }
+
+    // the source and the models that are not thread-safe run here
+    Backoff backoff;
+
+    for (bool running = true; running;) {
+        bool progress = false;
+        running = false;
+
+        for (auto &stage : stages) {
+            if (stage->threaded || stage->finished)
+                continue;
+
+            progress = step(*stage) || progress;
+            running = running || !stage->finished;
+        }
+
+        if (progress)
+            backoff.reset();
+        else if (running)
+            backoff.idle();
+    }
+
+    for (std::thread &thread : threads)
+        thread.join();
+
+    Report report;
+    report.frames = sourceStage->frameCount;
+    report.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    report.framesPerSecond = report.seconds > 0.0 ? report.frames / report.seconds : 0.0;
+
+    for (std::size_t i = 0; i < stages.size(); ++i) {
+        Stage &stage = *stages[i];
+
+        for (std::size_t j = 0; j < stage.inputs.size(); ++j) {
+            if (report.frames > 0)
+                stage.node->inputDelivered(stage.lastInputs[j], stage.inputs[j]->port, stage.inputs[j]->connectionId);
+        }
+
+        stage.node->nodeDataModel()->blockSignals(signalsBlocked[i]);
+        stage.node->recalculateVisuals();
+
+        report.stages.push_back({stage.node, stage.threaded,
+                                 std::chrono::duration<double>(stage.busy).count()});
+    }
+
+    return report;
+}
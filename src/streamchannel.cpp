@@ -0,0 +1,78 @@
+#include "streamchannel.h"
+
+#include <utility>
+
+StreamChannel::StreamChannel(std::size_t capacity)
+    : _queue(capacity)
+{
+}
+
+bool StreamChannel::tryPush(std::shared_ptr<NodeData> &&data)
+{
+    if (!_queue.tryPush(std::move(data)))
+        return false;
+
+    _pushed.fetch_add(1, std::memory_order_relaxed);
+
+    // 只有生产者写入_maxDepth
+    std::size_t const depth = _queue.size();
+    if (depth > _maxDepth.load(std::memory_order_relaxed))
+        _maxDepth.store(depth, std::memory_order_relaxed);
+
+    return true;
+}
+
+std::shared_ptr<NodeData> StreamChannel::tryPop()
+{
+    std::shared_ptr<NodeData> data;
+
+    if (_queue.tryPop(data))
+        _popped.fetch_add(1, std::memory_order_relaxed);
+
+    return data;
+}
+
+void StreamChannel::recordDrop()
+{
+    _dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+void StreamChannel::close()
+{
+    _closed.store(true, std::memory_order_release);
+}
+
+bool StreamChannel::isClosed() const
+{
+    return _closed.load(std::memory_order_acquire);
+}
+
+std::size_t StreamChannel::capacity() const
+{
+    return _queue.capacity();
+}
+
+std::size_t StreamChannel::depth() const
+{
+    return _queue.size();
+}
+
+std::size_t StreamChannel::maxDepth() const
+{
+    return _maxDepth.load(std::memory_order_relaxed);
+}
+
+std::size_t StreamChannel::pushedCount() const
+{
+    return _pushed.load(std::memory_order_relaxed);
+}
+
+std::size_t StreamChannel::poppedCount() const
+{
+    return _popped.load(std::memory_order_relaxed);
+}
+
+std::size_t StreamChannel::droppedCount() const
+{
+    return _dropped.load(std::memory_order_relaxed);
+}
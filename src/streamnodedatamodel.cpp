@@ -0,0 +1,217 @@
+#include "streamnodedatamodel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <utility>
+
+#include <QMutexLocker>
+#include <QThread>
+
+#include "connection.h"
+#include "node.h"
+
+namespace
+{
+
+template <typename Channels>
+void eraseConnection(Channels &channels, QUuid const &connectionId)
+{
+    channels.erase(std::remove_if(channels.begin(), channels.end(),
+                                  [&](auto const &c) { return c.connectionId == connectionId; }),
+                   channels.end());
+}
+
+}
+
+std::vector<StreamNodeDataModel::ChannelStats> StreamNodeDataModel::streamStats() const
+{
+    auto stats = [](QUuid const &id, PortType portType, PortIndex port, StreamChannel const &channel) {
+        return ChannelStats {id, portType, port,
+                             channel.depth(), channel.maxDepth(), channel.capacity(),
+                             channel.pushedCount(), channel.poppedCount(), channel.droppedCount()};
+    };
+
+    QMutexLocker locker(&_streamMutex);
+
+    std::vector<ChannelStats> result;
+    result.reserve(_inputs.size() + _outputs.size());
+
+    for (InputChannel const &input : _inputs)
+        result.push_back(stats(input.connectionId, PortType::In, input.port, *input.channel));
+
+    for (OutputChannel const &output : _outputs)
+        result.push_back(stats(output.connectionId, PortType::Out, output.port, *output.channel));
+
+    return result;
+}
+
+void StreamNodeDataModel::setInData(std::shared_ptr<NodeData>, PortIndex port)
+{
+    inputAvailable(port);
+}
+
+void StreamNodeDataModel::setInData(std::shared_ptr<NodeData> nodeData,
+                                    PortIndex port,
+                                    const QUuid &connectionId)
+{
+    std::shared_ptr<StreamChannel> bridge;
+
+    {
+        QMutexLocker locker(&_streamMutex);
+
+        for (InputChannel const &input : _inputs) {
+            if (input.connectionId == connectionId && input.bridged)
+                bridge = input.channel;
+        }
+    }
+
+    // 快照已由连接完成类型转换；本模型是这个队列唯一的生产者
+    if (bridge && nodeData && !bridge->tryPush(std::move(nodeData)))
+        bridge->recordDrop();
+
+    inputAvailable(port);
+}
+
+std::shared_ptr<NodeData> StreamNodeDataModel::outData(PortIndex port)
+{
+    QMutexLocker locker(&_streamMutex);
+
+    OutputPort &output = _outputPorts[port];
+    output.notifyPending = false;
+
+    return output.latest;
+}
+
+void StreamNodeDataModel::inputConnectionCreated(Connection const &connection)
+{
+    Node *outNode = connection.getNode(PortType::Out);
+    bool const bridged = !outNode
+            || !qobject_cast<StreamNodeDataModel *>(outNode->nodeDataModel());
+
+    QMutexLocker locker(&_streamMutex);
+
+    _inputs.push_back({connection.id(),
+                       connection.getPortIndex(PortType::In),
+                       connection.stream(),
+                       bridged ? TypeConverter{} : connection.typeConverter(),
+                       bridged});
+}
+
+void StreamNodeDataModel::inputConnectionDeleted(Connection const &connection)
+{
+    QMutexLocker locker(&_streamMutex);
+
+    eraseConnection(_inputs, connection.id());
+}
+
+void StreamNodeDataModel::outputConnectionCreated(Connection const &connection)
+{
+    // 非流式的下游只读取outData()，不会取走队列中的元素
+    Node *inNode = connection.getNode(PortType::In);
+    if (!inNode || !qobject_cast<StreamNodeDataModel *>(inNode->nodeDataModel()))
+        return;
+
+    QMutexLocker locker(&_streamMutex);
+
+    _outputs.push_back({connection.id(),
+                        connection.getPortIndex(PortType::Out),
+                        connection.stream()});
+}
+
+void StreamNodeDataModel::outputConnectionDeleted(Connection const &connection)
+{
+    QMutexLocker locker(&_streamMutex);
+
+    eraseConnection(_outputs, connection.id());
+}
+
+std::size_t StreamNodeDataModel::pushOut(PortIndex port, std::shared_ptr<NodeData> data)
+{
+    if (!data)
+        return 0;
+
+    std::vector<std::shared_ptr<StreamChannel>> channels;
+    bool notify = false;
+
+    {
+        QMutexLocker locker(&_streamMutex);
+
+        for (OutputChannel const &output : _outputs) {
+            if (output.port == port)
+                channels.push_back(output.channel);
+        }
+
+        OutputPort &output = _outputPorts[port];
+        output.latest = data;
+
+        notify = !output.notifyPending;
+        output.notifyPending = true;
+    }
+
+    bool const canBlock = backpressure(port) == Backpressure::Block
+            && QThread::currentThread() != thread();
+
+    std::size_t delivered = 0;
+
+    for (auto const &channel : channels) {
+        std::shared_ptr<NodeData> item = data;
+        bool pushed = false;
+
+        for (int attempt = 0; !(pushed = channel->tryPush(std::move(item))); ++attempt) {
+            if (!canBlock || channel->isClosed() || cancellationToken().isCancelled())
+                break;
+
+            if (attempt < 64)
+                std::this_thread::yield();
+            else
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+
+        if (pushed)
+            ++delivered;
+        else
+            channel->recordDrop();
+    }
+
+    // 跨线程时以排队方式送到节点，在GUI线程中传播
+    if (notify)
+        emit dataUpdated(port);
+
+    return delivered;
+}
+
+std::shared_ptr<NodeData> StreamNodeDataModel::pullIn(PortIndex port)
+{
+    std::vector<InputChannel> inputs;
+    std::size_t cursor = 0;
+
+    {
+        QMutexLocker locker(&_streamMutex);
+
+        for (InputChannel const &input : _inputs) {
+            if (input.port == port)
+                inputs.push_back(input);
+        }
+
+        cursor = _pullCursor[port];
+    }
+
+    std::shared_ptr<NodeData> data;
+
+    for (std::size_t i = 0; i < inputs.size() && !data; ++i) {
+        InputChannel const &input = inputs[(cursor + i) % inputs.size()];
+
+        data = input.channel->tryPop();
+
+        if (data && input.converter)
+            data = input.converter(data);
+
+        if (data) {
+            QMutexLocker locker(&_streamMutex);
+            _pullCursor[port] = cursor + i + 1;
+        }
+    }
+
+    return data;
+}
@@ -0,0 +1,247 @@
+#include "topologicalorder.h"
+
+#include <algorithm>
+
+void TopologicalOrder::addNode(Node *node)
+{
+    if (_slots.count(node))
+        return;
+
+    int s;
+
+    if (!_freeSlots.empty()) {
+        s = _freeSlots.back();
+        _freeSlots.pop_back();
+    } else {
+        s = static_cast<int>(_nodes.size());
+        _nodes.push_back(nullptr);
+        _positions.push_back(-1);
+        _successors.emplace_back();
+        _predecessors.emplace_back();
+        _marks.push_back(0);
+    }
+
+    _nodes[s] = node;
+    _slots[node] = s;
+
+    // a node without edges may go anywhere, appending keeps the order valid
+    _positions[s] = static_cast<int>(_order.size());
+    _order.push_back(s);
+}
+
+void TopologicalOrder::removeNode(Node *node)
+{
+    int const s = slot(node);
+    if (s < 0)
+        return;
+
+    for (auto const &edge : _successors[s])
+        _predecessors[edge.first].erase(s);
+
+    for (auto const &edge : _predecessors[s])
+        _successors[edge.first].erase(s);
+
+    _successors[s].clear();
+    _predecessors[s].clear();
+
+    _order[_positions[s]] = -1;
+    _positions[s] = -1;
+    _nodes[s] = nullptr;
+    _slots.erase(node);
+    _freeSlots.push_back(s);
+
+    if (++_holes * 2 > _order.size())
+        compact();
+}
+
+bool TopologicalOrder::addEdge(Node *from, Node *to)
+{
+    int const x = slot(from);
+    int const y = slot(to);
+
+    if (x < 0 || y < 0 || x == y)
+        return false;
+
+    auto it = _successors[x].find(y);
+    if (it != _successors[x].end()) {
+        ++it->second;
+        ++_predecessors[y][x];
+        return true;
+    }
+
+    int const lower = _positions[y];
+    int const upper = _positions[x];
+
+    if (lower < upper) {
+        std::vector<int> forward;
+        std::vector<int> backward;
+
+        // nodes reachable from 'to' inside the affected region,
+        // reaching 'from' means the edge closes a cycle
+        if (!collect(y, true, lower, upper, x, forward))
+            return false;
+
+        collect(x, false, lower, upper, -1, backward);
+        reorder(backward, forward);
+    }
+
+    _successors[x][y] = 1;
+    _predecessors[y][x] = 1;
+
+    return true;
+}
+
+void TopologicalOrder::removeEdge(Node *from, Node *to)
+{
+    int const x = slot(from);
+    int const y = slot(to);
+
+    if (x < 0 || y < 0)
+        return;
+
+    auto it = _successors[x].find(y);
+    if (it == _successors[x].end())
+        return;
+
+    if (--it->second == 0) {
+        _successors[x].erase(it);
+        _predecessors[y].erase(x);
+    } else {
+        --_predecessors[y][x];
+    }
+}
+
+bool TopologicalOrder::reaches(Node const *from, Node const *to) const
+{
+    if (from == to)
+        return true;
+
+    int const x = slot(from);
+    int const y = slot(to);
+
+    if (x < 0 || y < 0)
+        return false;
+
+    // every path only visits increasing positions
+    if (_positions[x] > _positions[y])
+        return false;
+
+    std::vector<int> visited;
+    return !collect(x, true, _positions[x], _positions[y], y, visited);
+}
+
+bool TopologicalOrder::createsCycle(Node const *from, Node const *to) const
+{
+    return reaches(to, from);
+}
+
+int TopologicalOrder::position(Node const *node) const
+{
+    int const s = slot(node);
+
+    return (s < 0) ? -1 : _positions[s];
+}
+
+std::vector<Node *> TopologicalOrder::nodes() const
+{
+    std::vector<Node *> result;
+    result.reserve(_slots.size());
+
+    for (int s : _order) {
+        if (s >= 0)
+            result.push_back(_nodes[s]);
+    }
+
+    return result;
+}
+
+std::size_t TopologicalOrder::size() const
+{
+    return _slots.size();
+}
+
+int TopologicalOrder::slot(Node const *node) const
+{
+    auto it = _slots.find(node);
+
+    return (it == _slots.end()) ? -1 : it->second;
+}
+
+bool TopologicalOrder::collect(int start, bool forward, int lower, int upper, int target,
+                               std::vector<int> &visited) const
+{
+    bool found = false;
+
+    std::vector<int> stack { start };
+    _marks[start] = 1;
+    visited.push_back(start);
+
+    while (!stack.empty() && !found) {
+        int const s = stack.back();
+        stack.pop_back();
+
+        for (auto const &edge : forward ? _successors[s] : _predecessors[s]) {
+            int const n = edge.first;
+
+            if (n == target) {
+                found = true;
+                break;
+            }
+
+            int const p = _positions[n];
+            if (_marks[n] || p < lower || p > upper)
+                continue;
+
+            _marks[n] = 1;
+            visited.push_back(n);
+            stack.push_back(n);
+        }
+    }
+
+    for (int s : visited)
+        _marks[s] = 0;
+
+    return !found;
+}
+
+void TopologicalOrder::reorder(std::vector<int> &backward, std::vector<int> &forward)
+{
+    auto byPosition = [this](int a, int b) { return _positions[a] < _positions[b]; };
+
+    std::sort(backward.begin(), backward.end(), byPosition);
+    std::sort(forward.begin(), forward.end(), byPosition);
+
+    std::vector<int> slots;
+    slots.reserve(backward.size() + forward.size());
+    slots.insert(slots.end(), backward.begin(), backward.end());
+    slots.insert(slots.end(), forward.begin(), forward.end());
+
+    std::vector<int> positions;
+    positions.reserve(slots.size());
+    for (int s : slots)
+        positions.push_back(_positions[s]);
+
+    std::sort(positions.begin(), positions.end());
+
+    for (std::size_t i = 0; i < slots.size(); ++i) {
+        _positions[slots[i]] = positions[i];
+        _order[positions[i]] = slots[i];
+    }
+}
+
+void TopologicalOrder::compact()
+{
+    std::vector<int> order;
+    order.reserve(_slots.size());
+
+    for (int s : _order) {
+        if (s < 0)
+            continue;
+
+        _positions[s] = static_cast<int>(order.size());
+        order.push_back(s);
+    }
+
+    _order.swap(order);
+    _holes = 0;
+}